@@ -0,0 +1,104 @@
+#include "Bench.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    std::atomic<unsigned long long> allocations(0);
+}
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+namespace bench
+{
+    Stopwatch::Stopwatch() : begin(std::chrono::steady_clock::now()) {}
+
+    double Stopwatch::seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    double Stopwatch::milliseconds() const
+    {
+        return seconds() * 1000;
+    }
+
+    unsigned long long allocationCount()
+    {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    double peakRssMb()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+    }
+
+    void writeConfig(const string &path, const ConfigShape &shape)
+    {
+        mt19937 random(12345);
+        uniform_int_distribution<int> price(0, shape.maxPrice);
+        uniform_int_distribution<int> score(0, shape.maxScore);
+        vector<string> policies;
+        istringstream names(shape.policies);
+        for (string name; names >> name;)
+        {
+            policies.push_back(name);
+        }
+
+        ofstream out(path.c_str());
+        for (int i = 0; i < shape.settlements; ++i)
+        {
+            out << "settlement s" << i << ' ' << (shape.settlementType < 0 ? i % 3 : shape.settlementType) << '\n';
+        }
+        for (int i = 0; i < shape.facilities; ++i)
+        {
+            out << "facility f" << i << ' ' << i % 3 << ' ' << price(random) << ' ' << score(random) << ' '
+                << score(random) << ' ' << score(random) << '\n';
+        }
+        for (int i = 0; i < shape.plans; ++i)
+        {
+            out << "plan s" << i % shape.settlements << ' ' << policies[i % policies.size()] << '\n';
+        }
+    }
+
+    string tempPath(const string &suffix)
+    {
+        return "/tmp/bench_" + to_string(getpid()) + "_" + suffix;
+    }
+}
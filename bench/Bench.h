@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+// Helpers shared by the benchmark drivers in bench/. Each driver is one .cpp linked against the
+// simulation's objects (all but main.o); "make bench" builds them into bin/bench/.
+namespace bench
+{
+    // Wall-clock time since construction
+    class Stopwatch
+    {
+    public:
+        Stopwatch();
+        double seconds() const;
+        double milliseconds() const;
+
+    private:
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    // Calls to operator new since the program started (Bench.cpp replaces the global operator new)
+    unsigned long long allocationCount();
+    // Peak resident set size of the process so far, in MB
+    double peakRssMb();
+
+    // A generated config; names are s<i> and f<i>, and every plan line names settlement s<i % settlements>
+    struct ConfigShape
+    {
+        int settlements;
+        int settlementType; // -1 for round-robin over 0..2
+        int facilities;
+        int maxPrice;       // Prices are drawn from [0, maxPrice]
+        int maxScore;       // Scores are drawn from [0, maxScore]
+        int plans;
+        std::string policies; // Plan i gets the i-th (round-robin) of these space-separated policy names
+    };
+
+    // Writes the config described by shape to path, with a fixed seed so runs are repeatable
+    void writeConfig(const std::string &path, const ConfigShape &shape);
+    // A file name under /tmp unique to this process, ending in suffix
+    std::string tempPath(const std::string &suffix);
+}
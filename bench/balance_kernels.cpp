@@ -0,0 +1,70 @@
+#include "Bench.h"
+#include "BalanceKernels.h"
+#include <climits>
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+// bench/balance_kernels: throughput of every balanced-scan kernel this CPU supports, in facility types
+// scored per ns, and a check that they all pick the same type on random ranges and totals
+int main()
+{
+    vector<BalanceKernelEntry> kernels = supportedBalanceKernels();
+    const size_t sizes[] = {64, 256, 4096, 100000, 1000000};
+
+    printf("%8s", "types");
+    for (const BalanceKernelEntry &kernel : kernels)
+    {
+        printf("  %8s", kernel.name);
+    }
+    printf("  disagreements\n");
+    for (size_t size : sizes)
+    {
+        mt19937 random(12345);
+        uniform_int_distribution<int> score(-1000, 1000);
+        vector<int> lifeQuality(size), economy(size), environment(size), unused(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            lifeQuality[i] = score(random);
+            economy[i] = score(random);
+            environment[i] = score(random);
+        }
+        FacilityColumns columns{lifeQuality.data(), economy.data(), environment.data(), unused.data(), unused.data(), size};
+
+        printf("%8zu", size);
+        size_t repeats = 20000000 / size + 1;
+        for (const BalanceKernelEntry &kernel : kernels)
+        {
+            int bestGap = INT_MAX, bestPosition = -1;
+            bench::Stopwatch timer;
+            for (size_t r = 0; r < repeats; ++r)
+            {
+                kernel.scan(columns, 0, size, static_cast<int>(r % 7), 3, 5, bestGap, bestPosition);
+            }
+            printf("  %8.3f", size * repeats / (timer.seconds() * 1e9));
+        }
+
+        int disagreements = 0;
+        uniform_int_distribution<size_t> position(0, size);
+        for (int check = 0; check < 2000; ++check)
+        {
+            size_t begin = position(random), end = position(random);
+            if (begin > end)
+            {
+                swap(begin, end);
+            }
+            int a = score(random) * 50, b = score(random) * 50, c = score(random) * 50;
+            int expectedGap = INT_MAX, expectedPosition = -1;
+            kernels.front().scan(columns, begin, end, a, b, c, expectedGap, expectedPosition);
+            for (const BalanceKernelEntry &kernel : kernels)
+            {
+                int bestGap = INT_MAX, bestPosition = -1;
+                kernel.scan(columns, begin, end, a, b, c, bestGap, bestPosition);
+                disagreements += bestGap != expectedGap || bestPosition != expectedPosition ? 1 : 0;
+            }
+        }
+        printf("  %d\n", disagreements);
+    }
+    return 0;
+}
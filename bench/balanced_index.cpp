@@ -0,0 +1,115 @@
+#include "Bench.h"
+#include "Facility.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+    // The balanced pick as BalancedSelection first wrote it: score every type, keep the first smallest gap
+    int scanMostBalanced(const FacilityCatalog &catalog, int lifeQuality, int economy, int environment)
+    {
+        int minDifference = INT_MAX;
+        int selected = -1;
+        for (size_t i = 0; i < catalog.size(); ++i)
+        {
+            int scoreA = lifeQuality + catalog[i].getLifeQualityScore();
+            int scoreB = economy + catalog[i].getEconomyScore();
+            int scoreC = environment + catalog[i].getEnvironmentScore();
+            int difference = max(max(abs(scoreA - scoreB), abs(scoreB - scoreC)), abs(scoreC - scoreA));
+            if (difference < minDifference)
+            {
+                minDifference = difference;
+                selected = static_cast<int>(i);
+            }
+        }
+        return selected;
+    }
+
+    struct Totals
+    {
+        int lifeQuality, economy, environment;
+    };
+
+    // Microseconds per pick over totals, and how many picks differ from the scan's
+    void timePicks(const FacilityCatalog &catalog, const vector<Totals> &totals, double &scanMicros, double &indexMicros, int &mismatches)
+    {
+        vector<int> scanPicks(totals.size()), indexPicks(totals.size());
+        bench::Stopwatch scanTimer;
+        for (size_t i = 0; i < totals.size(); ++i)
+        {
+            scanPicks[i] = scanMostBalanced(catalog, totals[i].lifeQuality, totals[i].economy, totals[i].environment);
+        }
+        scanMicros = scanTimer.milliseconds() * 1000 / totals.size();
+        bench::Stopwatch indexTimer;
+        for (size_t i = 0; i < totals.size(); ++i)
+        {
+            indexPicks[i] = catalog.mostBalanced(totals[i].lifeQuality, totals[i].economy, totals[i].environment);
+        }
+        indexMicros = indexTimer.milliseconds() * 1000 / totals.size();
+        mismatches = 0;
+        for (size_t i = 0; i < totals.size(); ++i)
+        {
+            mismatches += scanPicks[i] != indexPicks[i] ? 1 : 0;
+        }
+    }
+}
+
+// bench/balanced_index [picks]: the catalog's k-d tree search for the most balanced type against the
+// original scan, per pick, on random totals and on the totals a bal plan walks through
+int main(int argc, char **argv)
+{
+    int picks = argc > 1 ? atoi(argv[1]) : 200;
+    const struct
+    {
+        int types, maxScore;
+        bool skewed; // Life quality scores up to maxScore, the others up to 6
+    } catalogs[] = {{100000, 6, false}, {100000, 1000, false}, {100000, 100000, false}, {100000, 100000, true}, {1000000, 6, false}, {1000000, 1000, false}, {1000000, 100000, false}};
+
+    printf("%7s  %9s  %6s  %24s  %24s  %8s  %s\n", "types", "max score", "skewed", "random (scan / index)", "plan walk (scan / index)", "build",
+           "mismatches");
+    for (const auto &shape : catalogs)
+    {
+        mt19937 random(12345);
+        uniform_int_distribution<int> score(0, shape.maxScore), small(0, 6);
+        FacilityCatalog catalog;
+        for (int i = 0; i < shape.types; ++i)
+        {
+            int lifeQuality = score(random);
+            int economy = shape.skewed ? small(random) : score(random);
+            int environment = shape.skewed ? small(random) : score(random);
+            catalog.push_back(FacilityType("f" + to_string(i), static_cast<FacilityCategory>(i % 3), 1, lifeQuality, economy, environment));
+        }
+
+        bench::Stopwatch buildTimer;
+        catalog.mostBalanced(0, 0, 0); // The first search builds the tree
+        double buildMillis = buildTimer.milliseconds();
+
+        vector<Totals> randomTotals(picks), walkTotals(picks);
+        uniform_int_distribution<int> total(0, shape.maxScore * 50);
+        for (Totals &totals : randomTotals)
+        {
+            totals = Totals{total(random), total(random), total(random)};
+        }
+        Totals walk{0, 0, 0};
+        for (Totals &totals : walkTotals)
+        {
+            totals = walk;
+            const FacilityType &picked = catalog[catalog.mostBalanced(walk.lifeQuality, walk.economy, walk.environment)];
+            walk.lifeQuality += picked.getLifeQualityScore();
+            walk.economy += picked.getEconomyScore();
+            walk.environment += picked.getEnvironmentScore();
+        }
+
+        double randomScan, randomIndex, walkScan, walkIndex;
+        int randomMismatches, walkMismatches;
+        timePicks(catalog, randomTotals, randomScan, randomIndex, randomMismatches);
+        timePicks(catalog, walkTotals, walkScan, walkIndex, walkMismatches);
+        printf("%7d  %9d  %6s  %9.0f us / %6.2f us  %9.0f us / %6.2f us  %5.0f ms  %d\n", shape.types, shape.maxScore, shape.skewed ? "yes" : "no",
+               randomScan, randomIndex, walkScan, walkIndex, buildMillis, randomMismatches + walkMismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "Bench.h"
+#include "Action.h"
+#include "backup.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool passed, const char *check)
+    {
+        printf("%-60s %s\n", check, passed ? "ok" : "FAILED");
+        failures += passed ? 0 : 1;
+    }
+
+    // What planStatus prints for a plan
+    string planStatus(Simulation &simulation, int planId)
+    {
+        ostringstream output;
+        streambuf *saved = cout.rdbuf(output.rdbuf());
+        PrintPlanStatus(planId).act(simulation);
+        cout.rdbuf(saved);
+        return output.str();
+    }
+}
+
+// bench/change_policy [plans]: checks that changePolicy reaches the stored plan (planStatus shows it, the
+// scores follow it, a backup keeps the old one), then ns and allocations per planStatus and changePolicy
+// over all plans while a backup shares them. Exits with 1 when a check fails.
+int main(int argc, char **argv)
+{
+    int plans = argc > 1 ? atoi(argv[1]) : 20000;
+
+    // Economy types only score economy and sustainability types only environment, so the policy shows in the scores
+    string config = bench::tempPath("change_policy.txt");
+    {
+        ofstream file(config);
+        file << "settlement A 2\nfacility Eco 1 1 0 5 0\nfacility Env 2 1 0 0 5\nplan A eco\n";
+    }
+    {
+        Simulation changed(config), unchanged(config);
+        BackupSimulation().act(changed);
+        ChangePlanPolicy change(0, "env");
+        change.act(changed);
+        expect(change.getStatus() == ActionStatus::COMPLETED, "changePolicy completes");
+        expect(planStatus(changed, 0).find("SelectionPolicy: env\n") != string::npos, "planStatus shows the new policy");
+
+        changed.step(10);
+        unchanged.step(10);
+        const Plan &after = static_cast<const Simulation &>(changed).getPlan(0);
+        const Plan &before = static_cast<const Simulation &>(unchanged).getPlan(0);
+        expect(after.getEnvironmentScore() > 0 && before.getEnvironmentScore() == 0, "the new policy's scores grow");
+        expect(after.getEconomyScore() == 0 && before.getEconomyScore() > 0, "the old policy's scores stop");
+
+        ChangePlanPolicy again(0, "env");
+        again.act(changed);
+        expect(again.getStatus() == ActionStatus::ERROR, "changing to the current policy is an error");
+
+        RestoreSimulation().act(changed);
+        expect(planStatus(changed, 0).find("SelectionPolicy: eco\n") != string::npos, "the backup keeps the old policy");
+    }
+    remove(config.c_str());
+
+    config = bench::tempPath("change_policy_plans.txt");
+    bench::writeConfig(config, bench::ConfigShape{plans, -1, 50, 5, 5, plans, "eco env"});
+    Simulation simulation(config);
+    remove(config.c_str());
+    simulation.step(5);
+    BackupSimulation().act(simulation);
+
+    ofstream discard("/dev/null");
+    streambuf *saved = cout.rdbuf(discard.rdbuf());
+    unsigned long long allocations = bench::allocationCount();
+    bench::Stopwatch statusTimer;
+    for (int p = 0; p < plans; ++p)
+    {
+        PrintPlanStatus(p).act(simulation);
+    }
+    double statusNs = statusTimer.seconds() * 1e9 / plans;
+    double statusAllocations = double(bench::allocationCount() - allocations) / plans;
+
+    allocations = bench::allocationCount();
+    bench::Stopwatch changeTimer;
+    for (int p = 0; p < plans; ++p)
+    {
+        ChangePlanPolicy(p, p % 2 == 0 ? "env" : "eco").act(simulation); // Plan p starts with the other one
+    }
+    double changeNs = changeTimer.seconds() * 1e9 / plans;
+    double changeAllocations = double(bench::allocationCount() - allocations) / plans;
+    cout.rdbuf(saved);
+
+    printf("\n%d plans, a backup sharing them\n%-34s %9s  %s\n", plans, "", "ns/command", "allocations/command");
+    printf("%-34s %9.1f  %6.2f\n", "planStatus", statusNs, statusAllocations);
+    printf("%-34s %9.1f  %6.2f\n", "changePolicy", changeNs, changeAllocations);
+    return failures > 0 ? 1 : 0;
+}
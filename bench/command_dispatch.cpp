@@ -0,0 +1,182 @@
+#include "Bench.h"
+#include "Action.h"
+#include "Auxiliary.h"
+#include "Commands.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int PLANS = 100;
+
+    // A recorded-style trace: changePolicy (always a real change), planStatus, settlement, facility,
+    // an unknown verb and a blank line, in turn
+    vector<string> makeTrace(int lines)
+    {
+        vector<string> trace;
+        vector<bool> economy(PLANS);
+        for (int p = 0; p < PLANS; ++p)
+        {
+            economy[p] = p % 2 == 0; // The config's "eco env" round robin
+        }
+        for (int i = 0; i < lines; ++i)
+        {
+            int plan = (i / 6) % PLANS;
+            switch (i % 6)
+            {
+            case 0:
+                economy[plan] = !economy[plan];
+                trace.push_back("changePolicy " + to_string(plan) + (economy[plan] ? " eco" : " env"));
+                break;
+            case 1:
+                trace.push_back("planStatus " + to_string(plan));
+                break;
+            case 2:
+                trace.push_back("settlement t" + to_string(i) + " 1");
+                break;
+            case 3:
+                trace.push_back("facility g" + to_string(i) + " 1 2 1 1 1");
+                break;
+            case 4:
+                trace.push_back("frobnicate " + to_string(i) + " 2");
+                break;
+            default:
+                trace.push_back("");
+                break;
+            }
+        }
+        return trace;
+    }
+
+    // The dispatch Simulation::start() used to do: a vector<string> per line, an if/else chain over the verbs
+    // and the action on the heap. Returns nullptr for an unknown command.
+    BaseAction *chainDispatch(const string &line)
+    {
+        vector<string> args = Auxiliary::parseArguments(line);
+        if (args.empty())
+            return nullptr;
+        if (args[0] == "step" && args.size() == 2)
+            return new SimulateStep(stoi(args[1]));
+        if (args[0] == "plan" && args.size() == 3)
+            return new AddPlan(args[1], args[2]);
+        if (args[0] == "settlement" && args.size() == 3)
+            return new AddSettlement(args[1], static_cast<SettlementType>(stoi(args[2])));
+        if (args[0] == "facility" && args.size() == 7)
+            return new AddFacility(args[1], static_cast<FacilityCategory>(stoi(args[2])), stoi(args[3]), stoi(args[4]), stoi(args[5]), stoi(args[6]));
+        if (args[0] == "planStatus" && args.size() == 2)
+            return new PrintPlanStatus(stoi(args[1]));
+        if (args[0] == "changePolicy" && args.size() == 3)
+            return new ChangePlanPolicy(stoi(args[1]), args[2]);
+        if (args[0] == "log" && args.size() == 1)
+            return new PrintActionsLog();
+        if (args[0] == "backup" && args.size() == 1)
+            return new BackupSimulation();
+        if (args[0] == "restore" && args.size() == 1)
+            return new RestoreSimulation();
+        if (args[0] == "close" && args.size() == 1)
+            return new Close();
+        return nullptr;
+    }
+}
+
+// bench/command_dispatch [lines]: per-command cost of the REPL's command handling over a generated trace.
+// First the tokenizer alone, the old parseArguments (a vector<string> per line) against splitArguments
+// (views into the line); then the dispatch without running anything, the old if/else chain with the action on
+// the heap against findCommand with the action built in an ActionStorage; then whole commands run through
+// --batch with the output discarded, which adds running the action and logging it.
+int main(int argc, char **argv)
+{
+    int lines = argc > 1 ? atoi(argv[1]) : 300000;
+    vector<string> trace = makeTrace(lines);
+
+    size_t checksum = 0;
+    unsigned long long allocations = bench::allocationCount();
+    bench::Stopwatch parseTimer;
+    for (const string &line : trace)
+    {
+        checksum += Auxiliary::parseArguments(line).size();
+    }
+    double parseNs = parseTimer.seconds() * 1e9 / lines;
+    double parseAllocations = double(bench::allocationCount() - allocations) / lines;
+
+    ArgumentView arguments[8];
+    allocations = bench::allocationCount();
+    bench::Stopwatch splitTimer;
+    for (const string &line : trace)
+    {
+        checksum += Auxiliary::splitArguments(line.data(), line.data() + line.size(), arguments, 8);
+    }
+    double splitNs = splitTimer.seconds() * 1e9 / lines;
+    double splitAllocations = double(bench::allocationCount() - allocations) / lines;
+
+    allocations = bench::allocationCount();
+    bench::Stopwatch chainTimer;
+    for (const string &line : trace)
+    {
+        BaseAction *action = chainDispatch(line);
+        checksum += action != nullptr;
+        delete action;
+    }
+    double chainNs = chainTimer.seconds() * 1e9 / lines;
+    double chainAllocations = double(bench::allocationCount() - allocations) / lines;
+
+    ArgumentView args[MAX_COMMAND_ARGUMENTS];
+    allocations = bench::allocationCount();
+    bench::Stopwatch tableTimer;
+    for (const string &line : trace)
+    {
+        int argCount = Auxiliary::splitArguments(line.data(), line.data() + line.size(), args, MAX_COMMAND_ARGUMENTS);
+        if (argCount == 0)
+            continue;
+        const Command *command = findCommand(args, argCount);
+        ActionStorage storage;
+        BaseAction *action = command ? command->build(args, &storage) : nullptr;
+        checksum += action != nullptr;
+        if (action)
+            action->~BaseAction();
+    }
+    double tableNs = tableTimer.seconds() * 1e9 / lines;
+    double tableAllocations = double(bench::allocationCount() - allocations) / lines;
+
+    string config = bench::tempPath("command_dispatch_config.txt");
+    string commands = bench::tempPath("command_dispatch_trace.txt");
+    bench::writeConfig(config, bench::ConfigShape{PLANS, -1, 50, 5, 5, PLANS, "eco env"});
+    {
+        ofstream file(commands);
+        for (const string &line : trace)
+        {
+            file << line << '\n';
+        }
+    }
+
+    double batchNs, batchAllocations;
+    {
+        Simulation simulation(config);
+        ofstream discard("/dev/null");
+        streambuf *saved = cout.rdbuf(discard.rdbuf());
+        allocations = bench::allocationCount();
+        bench::Stopwatch batchTimer;
+        simulation.startBatch(commands);
+        batchNs = batchTimer.seconds() * 1e9 / lines;
+        batchAllocations = double(bench::allocationCount() - allocations) / lines;
+        cout.rdbuf(saved);
+    }
+    remove(config.c_str());
+    remove(commands.c_str());
+
+    printf("%-34s %9s  %s\n", "", "ns/line", "allocations/line");
+    printf("%-34s %9.1f  %6.2f\n", "parseArguments (old tokenizer)", parseNs, parseAllocations);
+    printf("%-34s %9.1f  %6.2f\n", "splitArguments", splitNs, splitAllocations);
+    printf("%-34s %9.1f  %6.2f\n", "dispatch, old if/else + new", chainNs, chainAllocations);
+    printf("%-34s %9.1f  %6.2f\n", "dispatch, findCommand + in place", tableNs, tableAllocations);
+    printf("%-34s %9.1f  %6.2f\n", "--batch, whole commands", batchNs, batchAllocations);
+    printf("(checksum %zu)\n", checksum);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "Bench.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    struct Shape
+    {
+        const char *name;
+        bench::ConfigShape config;
+    };
+
+    const Shape SHAPES[] = {
+        // Every settlement and facility line checks for a duplicate name
+        {"names", {100000, -1, 100000, 5, 5, 1000, "nve bal eco env"}},
+        // A million lines, mostly plans
+        {"mixed", {200000, -1, 800, 5, 5, 800000, "nve bal eco env"}},
+        // A million settlement lines: the tokenizer and the name index
+        {"settle", {1000000, -1, 0, 5, 5, 0, "nve"}},
+    };
+}
+
+// bench/config_load [shape]: time and heap allocations to load a generated config and drop the simulation
+// again (what 'close' costs), for each shape or only the named one
+int main(int argc, char **argv)
+{
+    printf("shape       lines  seconds  allocations\n");
+    for (const Shape &shape : SHAPES)
+    {
+        if (argc > 1 && strcmp(argv[1], shape.name) != 0)
+        {
+            continue;
+        }
+        string config = bench::tempPath("config_load.txt");
+        bench::writeConfig(config, shape.config);
+
+        unsigned long long allocations = bench::allocationCount();
+        bench::Stopwatch timer;
+        {
+            Simulation simulation(config);
+        }
+        double seconds = timer.seconds();
+        int lines = shape.config.settlements + shape.config.facilities + shape.config.plans;
+        printf("%-8s %8d  %7.3f  %11llu\n", shape.name, lines, seconds, bench::allocationCount() - allocations);
+        remove(config.c_str());
+    }
+    return 0;
+}
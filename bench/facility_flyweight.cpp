@@ -0,0 +1,97 @@
+#include "Bench.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // What a Facility used to be: a copy of its FacilityType plus the settlement's name, each on the heap
+    struct FullFacility
+    {
+        string name;
+        FacilityCategory category;
+        int price, lifeQualityScore, economyScore, environmentScore;
+        string settlementName;
+        FacilityStatus status;
+        int timeLeft;
+    };
+
+    FullFacility *makeFull(const FacilityType &type, const string &settlementName, FacilityStatus status, int timeLeft)
+    {
+        return new FullFacility{type.getName(), type.getCategory(), type.getCost(), type.getLifeQualityScore(),
+                                type.getEconomyScore(), type.getEnvironmentScore(), settlementName, status, timeLeft};
+    }
+}
+
+// bench/facility_flyweight [plans] [steps]: heap allocations (operator new calls), peak RSS and time for
+// loading a generated config (500 facility types, 1000 settlements, mixed policies) and running
+// 'step <steps>'. Then, for comparison, the same facilities again as full Facility copies, one heap object per
+// facility with its own name and settlement name, as the plans used to keep them.
+int main(int argc, char **argv)
+{
+    int plans = argc > 1 ? atoi(argv[1]) : 200000;
+    int steps = argc > 2 ? atoi(argv[2]) : 50;
+
+    string config = bench::tempPath("facility_flyweight.txt");
+    bench::writeConfig(config, bench::ConfigShape{1000, -1, 500, 5, 5, plans, "nve bal eco env"});
+
+    unsigned long long allocations = bench::allocationCount();
+    bench::Stopwatch loadTimer;
+    Simulation simulation(config);
+    double loadSeconds = loadTimer.seconds();
+    unsigned long long loadAllocations = bench::allocationCount() - allocations;
+
+    allocations = bench::allocationCount();
+    bench::Stopwatch stepTimer;
+    simulation.step(steps);
+    double stepSeconds = stepTimer.seconds();
+    unsigned long long stepAllocations = bench::allocationCount() - allocations;
+
+    size_t facilities = 0;
+    for (int i = 0; i < simulation.getPlanCount(); ++i)
+    {
+        facilities += simulation.getPlan(i).getFacilities().size() + simulation.getPlan(i).getUnderConstruction().size();
+    }
+    printf("%d plans, step %d, %zu facilities started\n", plans, steps, facilities);
+    printf("load: %8.3f s  %10llu allocations\n", loadSeconds, loadAllocations);
+    printf("step: %8.3f s  %10llu allocations\n", stepSeconds, stepAllocations);
+    double flyweightRss = bench::peakRssMb();
+    printf("peak RSS: %.1f MB\n", flyweightRss);
+
+    allocations = bench::allocationCount();
+    bench::Stopwatch fullTimer;
+    vector<FullFacility *> full;
+    full.reserve(facilities);
+    for (int i = 0; i < simulation.getPlanCount(); ++i)
+    {
+        const Plan &plan = simulation.getPlan(i);
+        const string &settlementName = plan.getSettlement().getName();
+        for (const FacilityType &type : plan.getFacilities())
+        {
+            full.push_back(makeFull(type, settlementName, FacilityStatus::OPERATIONAL, 0));
+        }
+        for (const Facility &facility : plan.getUnderConstruction())
+        {
+            full.push_back(makeFull(facility.getType(), settlementName, facility.getStatus(), facility.getTimeLeft()));
+        }
+    }
+    double fullSeconds = fullTimer.seconds();
+    unsigned long long fullAllocations = bench::allocationCount() - allocations - 1; // Less the reserve
+
+    printf("\n%-34s %12s  %12s\n", "", "flyweight", "full copies");
+    printf("%-34s %12zu  %12zu\n", "bytes per facility object", sizeof(Facility), sizeof(FullFacility));
+    // The flyweight column is everything step allocated (growing vectors, cycle detection), not Facility objects
+    printf("%-34s %12.2f  %12.2f\n", "allocations per facility", double(stepAllocations) / facilities, double(fullAllocations) / facilities);
+    printf("%-34s %12s  %12.3f\n", "seconds to build them all", "-", fullSeconds);
+    printf("%-34s %12.1f  %12.1f\n", "peak RSS so far (MB)", flyweightRss, bench::peakRssMb());
+    for (FullFacility *facility : full)
+    {
+        delete facility;
+    }
+    remove(config.c_str());
+    return 0;
+}
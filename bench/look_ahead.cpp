@@ -0,0 +1,82 @@
+#include "Bench.h"
+#include "SelectionPolicy.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool passed, const char *check)
+    {
+        printf("%-60s %s\n", check, passed ? "ok" : "FAILED");
+        failures += passed ? 0 : 1;
+    }
+
+    // The name of the type an opt policy with these settings picks first from catalog
+    string firstPick(const FacilityCatalog &catalog, const LookAheadSettings &settings)
+    {
+        LookAheadSelection policy(settings);
+        return policy.selectFacility(catalog).getName();
+    }
+}
+
+// bench/look_ahead [types]: checks of what the opt policy picks, then the time of a first pick (which plans
+// the runs) on a random catalog for growing horizons. Exits with 1 when a check fails.
+int main(int argc, char **argv)
+{
+    int types = argc > 1 ? atoi(argv[1]) : 100000;
+
+    FacilityCatalog negative;
+    negative.push_back(FacilityType("Neg", FacilityCategory::LIFE_QUALITY, -1, 9, 9, 9));
+    negative.push_back(FacilityType("Ok", FacilityCategory::LIFE_QUALITY, 2, 1, 1, 1));
+    expect(firstPick(negative, LookAheadSettings{4, 1, 1, 1}) == "Ok", "a negative price (never finishes) is not picked");
+
+    FacilityCatalog allNegative;
+    allNegative.push_back(FacilityType("Neg", FacilityCategory::LIFE_QUALITY, -1, 9, 9, 9));
+    expect(firstPick(allNegative, LookAheadSettings{4, 1, 1, 1}) == "Neg", "with only negative prices, one of them is still picked");
+
+    FacilityCatalog weighted;
+    weighted.push_back(FacilityType("Life", FacilityCategory::LIFE_QUALITY, 2, 9, 0, 0));
+    weighted.push_back(FacilityType("Eco", FacilityCategory::ECONOMY, 2, 0, 5, 0));
+    expect(firstPick(weighted, LookAheadSettings{4, 1, 1, 1}) == "Life", "equal weights pick the highest total");
+    expect(firstPick(weighted, LookAheadSettings{4, 0, 1, 0}) == "Eco", "economy weight only picks the economy type");
+
+    // The case from the review: a plan must keep completing facilities next to a negative-price type
+    string config = bench::tempPath("look_ahead.txt");
+    {
+        ofstream file(config);
+        file << "settlement A 2\nfacility Neg 0 -1 9 9 9\nfacility Ok 0 2 1 1 1\nplan A opt 4\n";
+    }
+    {
+        Simulation simulation(config);
+        simulation.step(20);
+        const Plan &plan = static_cast<const Simulation &>(simulation).getPlan(0);
+        expect(plan.getlifeQualityScore() > 0 && plan.getEconomyScore() > 0 && plan.getEnvironmentScore() > 0,
+               "a plan next to a negative price keeps scoring");
+    }
+    remove(config.c_str());
+
+    mt19937 random(12345);
+    uniform_int_distribution<int> price(-1, 50), score(0, 100);
+    FacilityCatalog catalog;
+    for (int i = 0; i < types; ++i)
+    {
+        catalog.push_back(FacilityType("f" + to_string(i), static_cast<FacilityCategory>(i % 3), price(random), score(random), score(random), score(random)));
+    }
+    printf("\n%d types\n horizon  first pick (ms)\n", types);
+    for (int horizon = 10; horizon <= LookAheadSelection::MAX_HORIZON; horizon *= 10)
+    {
+        LookAheadSelection policy(LookAheadSettings{horizon, 1, 2, 3});
+        bench::Stopwatch timer;
+        const FacilityType &picked = policy.selectFacility(catalog);
+        printf("%8d  %15.3f  (%s)\n", horizon, timer.milliseconds(), picked.getName().c_str());
+    }
+    return failures > 0 ? 1 : 0;
+}
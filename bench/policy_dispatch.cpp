@@ -0,0 +1,92 @@
+#include "Bench.h"
+#include "SelectionPolicy.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace std;
+
+namespace
+{
+    // What Plan::step does: switch on the kind once, then call the final class directly
+    template <typename Policy>
+    void pick(SelectionPolicy &policy, const FacilityCatalog &catalog, int count, int *positions)
+    {
+        static_cast<Policy &>(policy).selectFacilities(catalog, count, positions);
+    }
+
+    void pickByKind(SelectionPolicy &policy, const FacilityCatalog &catalog, int count, int *positions)
+    {
+        switch (policy.getKind())
+        {
+        case PolicyKind::NAIVE:
+            pick<NaiveSelection>(policy, catalog, count, positions);
+            break;
+        case PolicyKind::BALANCED:
+            pick<BalancedSelection>(policy, catalog, count, positions);
+            break;
+        case PolicyKind::ECONOMY:
+            pick<EconomySelection>(policy, catalog, count, positions);
+            break;
+        case PolicyKind::SUSTAINABILITY:
+            pick<SustainabilitySelection>(policy, catalog, count, positions);
+            break;
+        case PolicyKind::LOOK_AHEAD:
+            pick<LookAheadSelection>(policy, catalog, count, positions);
+            break;
+        }
+    }
+}
+
+// bench/policy_dispatch [rounds]: ns per pick for 20000 mixed round-robin policies over 60 types, picking
+// one at a time through the virtual selectFacility, in virtual batches, and in batches after a kind switch
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 50;
+    const int POLICIES = 20000;
+    const PolicyKind kinds[] = {PolicyKind::NAIVE, PolicyKind::ECONOMY, PolicyKind::SUSTAINABILITY};
+
+    FacilityCatalog catalog;
+    for (int i = 0; i < 60; ++i)
+    {
+        catalog.push_back(FacilityType("f" + to_string(i), static_cast<FacilityCategory>(i % 3), 1 + i % 5, i % 4, i % 3, i % 5));
+    }
+    vector<unique_ptr<SelectionPolicy>> policies;
+    for (int i = 0; i < POLICIES; ++i)
+    {
+        policies.emplace_back(SelectionPolicy::create(kinds[i % 3], 0, 0, 0, LookAheadSettings{0, 1, 1, 1}));
+    }
+
+    int positions[3];
+    long long checksum = 0;
+    auto measure = [&](const char *label, int picksPerCall, void (*call)(SelectionPolicy &, const FacilityCatalog &, int *))
+    {
+        bench::Stopwatch timer;
+        for (int round = 0; round < rounds; ++round)
+        {
+            for (auto &policy : policies)
+            {
+                call(*policy, catalog, positions);
+                checksum += positions[0];
+            }
+        }
+        printf("%-40s %6.1f ns/pick\n", label, timer.seconds() * 1e9 / (double(rounds) * POLICIES * picksPerCall));
+    };
+
+    measure("virtual selectFacility, 3 picks", 3, [](SelectionPolicy &policy, const FacilityCatalog &catalog, int *positions)
+            {
+        for (int i = 0; i < 3; ++i)
+        {
+            positions[i] = static_cast<int>(&policy.selectFacility(catalog) - catalog.data());
+        } });
+    measure("virtual selectFacilities, batch of 3", 3, [](SelectionPolicy &policy, const FacilityCatalog &catalog, int *positions)
+            { policy.selectFacilities(catalog, 3, positions); });
+    measure("kind switch to final class, batch of 3", 3, [](SelectionPolicy &policy, const FacilityCatalog &catalog, int *positions)
+            { pickByKind(policy, catalog, 3, positions); });
+    measure("virtual selectFacilities, batch of 1", 1, [](SelectionPolicy &policy, const FacilityCatalog &catalog, int *positions)
+            { policy.selectFacilities(catalog, 1, positions); });
+    measure("kind switch to final class, batch of 1", 1, [](SelectionPolicy &policy, const FacilityCatalog &catalog, int *positions)
+            { pickByKind(policy, catalog, 1, positions); });
+    printf("(checksum %lld)\n", checksum);
+    return 0;
+}
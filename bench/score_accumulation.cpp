@@ -0,0 +1,62 @@
+#include "Bench.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+// bench/score_accumulation [max_steps] [max_rescan_steps]: one bal plan in a metropolis over price-0 facility
+// types, so it finishes three facilities every step. Scores are added as facilities finish, so the time per
+// step should stay flat as the plan's facility count grows. The rescan column is the old way for comparison:
+// stepping one at a time and summing the scores over every operational facility after each step, which grows
+// with the facility count. It is quadratic in the steps, so it only runs up to max_rescan_steps.
+int main(int argc, char **argv)
+{
+    int maxSteps = argc > 1 ? atoi(argv[1]) : 333333;
+    int maxRescanSteps = argc > 2 ? atoi(argv[2]) : 33333;
+
+    string config = bench::tempPath("score_accumulation.txt");
+    bench::writeConfig(config, bench::ConfigShape{1, 2, 60, 0, 5, 1, "bal"});
+
+    bool scoresMatch = true;
+    printf("   steps  facilities  incremental ms   us/step  rescan ms   us/step\n");
+    for (int steps = 3333; steps <= maxSteps; steps = steps * 10 + 3)
+    {
+        Simulation simulation(config);
+        bench::Stopwatch timer;
+        simulation.step(steps);
+        double milliseconds = timer.milliseconds();
+        const Plan &plan = simulation.getPlan(0);
+        printf("%8d  %10zu  %14.1f  %8.3f", steps, plan.getFacilities().size(), milliseconds, milliseconds * 1000 / steps);
+
+        if (steps > maxRescanSteps)
+        {
+            printf("  %9s  %8s\n", "-", "-");
+            continue;
+        }
+        Simulation rescanned(config);
+        int lifeQuality = 0, economy = 0, environment = 0;
+        bench::Stopwatch rescanTimer;
+        for (int step = 0; step < steps; ++step)
+        {
+            rescanned.step(1);
+            lifeQuality = economy = environment = 0;
+            for (const FacilityType &facility : rescanned.getPlan(0).getFacilities())
+            {
+                lifeQuality += facility.getLifeQualityScore();
+                economy += facility.getEconomyScore();
+                environment += facility.getEnvironmentScore();
+            }
+        }
+        double rescanMilliseconds = rescanTimer.milliseconds();
+        printf("  %9.1f  %8.3f\n", rescanMilliseconds, rescanMilliseconds * 1000 / steps);
+        scoresMatch = scoresMatch && lifeQuality == plan.getlifeQualityScore() && economy == plan.getEconomyScore() && environment == plan.getEnvironmentScore();
+    }
+    remove(config.c_str());
+    if (!scoresMatch)
+    {
+        printf("FAILED: the rescanned scores differ from the accumulated ones\n");
+        return 1;
+    }
+    return 0;
+}
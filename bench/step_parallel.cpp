@@ -0,0 +1,47 @@
+#include "Bench.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+// Sum of every plan's scores, to check that all worker counts simulate the same thing
+static long long checksum(const Simulation &simulation)
+{
+    long long sum = 0;
+    for (int i = 0; i < simulation.getPlanCount(); ++i)
+    {
+        const Plan &plan = simulation.getPlan(i);
+        sum += plan.getlifeQualityScore() + 3LL * plan.getEconomyScore() + 7LL * plan.getEnvironmentScore();
+    }
+    return sum;
+}
+
+// bench/step_parallel [plans] [steps] [max_workers]: 'step <steps>' over a generated config, with
+// 1, 2, 4, ... up to max_workers worker threads
+int main(int argc, char **argv)
+{
+    int plans = argc > 1 ? atoi(argv[1]) : 20000;
+    int steps = argc > 2 ? atoi(argv[2]) : 200;
+    int maxWorkers = argc > 3 ? atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+
+    string config = bench::tempPath("step_parallel.txt");
+    bench::writeConfig(config, bench::ConfigShape{100, -1, 60, 5, 5, plans, "nve bal eco env"});
+
+    cout << plans << " plans, step " << steps << " (" << std::thread::hardware_concurrency() << " hardware threads)" << endl;
+    cout << "workers  seconds  speedup  checksum" << endl;
+    double serial = 0;
+    for (int workers = 1; workers <= max(maxWorkers, 1); workers *= 2)
+    {
+        Simulation simulation(config, workers);
+        bench::Stopwatch timer;
+        simulation.step(steps);
+        double seconds = timer.seconds();
+        serial = workers == 1 ? seconds : serial;
+        printf("%7d  %7.3f  %6.2fx  %lld\n", workers, seconds, serial / seconds, checksum(simulation));
+    }
+    remove(config.c_str());
+    return 0;
+}
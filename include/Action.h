@@ -18,6 +18,7 @@ public:
     ActionStatus getStatus() const;
     virtual void act(Simulation &simulation) = 0;
     virtual const string toString() const = 0;
+    virtual void record(ActionJournal &journal) const = 0; // Append this action as toString() would render it
     virtual BaseAction *clone() const = 0;
     virtual ~BaseAction() = default;
 
@@ -38,6 +39,7 @@ public:
     SimulateStep(const int numOfSteps);
     void act(Simulation &simulation) override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
     SimulateStep *clone() const override;
 
 private:
@@ -50,6 +52,7 @@ public:
     AddPlan(const string &settlementName, const string &selectionPolicy);
     void act(Simulation &simulation) override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
     AddPlan *clone() const override;
 
 private:
@@ -64,6 +67,7 @@ public:
     void act(Simulation &simulation) override;
     AddSettlement *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
     const string settlementName;
@@ -77,6 +81,7 @@ public:
     void act(Simulation &simulation) override;
     AddFacility *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
     const string facilityName;
@@ -94,6 +99,7 @@ public:
     void act(Simulation &simulation) override;
     PrintPlanStatus *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
     const int planId;
@@ -106,12 +112,43 @@ public:
     void act(Simulation &simulation) override;
     ChangePlanPolicy *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
     const int planId;
     const string newPolicy;
 };
 
+// Print how the plan's scores would end up after numOfSteps under each policy, without changing it
+class ComparePolicies : public BaseAction
+{
+public:
+    ComparePolicies(const int planId, const int numOfSteps);
+    void act(Simulation &simulation) override;
+    ComparePolicies *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+    const int planId;
+    const int numOfSteps;
+};
+
+// Switch every plan to the policy whose outcome after numOfSteps ranks best by objective
+class AutotunePolicies : public BaseAction
+{
+public:
+    AutotunePolicies(const int numOfSteps, const string &objective);
+    void act(Simulation &simulation) override;
+    AutotunePolicies *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+    const int numOfSteps;
+    const string objective;
+};
+
 class PrintActionsLog : public BaseAction
 {
 public:
@@ -119,8 +156,36 @@ public:
     void act(Simulation &simulation) override;
     PrintActionsLog *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+};
+
+// Go back to the state after the first actionIndex actions, see Simulation::rewind
+class RewindSimulation : public BaseAction
+{
+public:
+    RewindSimulation(const int actionIndex);
+    void act(Simulation &simulation) override;
+    RewindSimulation *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
+    const int actionIndex;
+};
+
+class SourceCommands : public BaseAction
+{
+public:
+    SourceCommands(const string &path);
+    void act(Simulation &simulation) override;
+    SourceCommands *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+    const string path;
 };
 
 class Close : public BaseAction
@@ -130,6 +195,7 @@ public:
     void act(Simulation &simulation) override;
     Close *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
 };
@@ -141,6 +207,7 @@ public:
     void act(Simulation &simulation) override;
     BackupSimulation *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
 };
@@ -152,6 +219,32 @@ public:
     void act(Simulation &simulation) override;
     RestoreSimulation *clone() const override;
     const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+};
+class SaveSimulation : public BaseAction
+{
+public:
+    SaveSimulation(const string &path);
+    void act(Simulation &simulation) override;
+    SaveSimulation *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
+
+private:
+    const string path;
+};
+
+class LoadSimulation : public BaseAction
+{
+public:
+    LoadSimulation(const string &path);
+    void act(Simulation &simulation) override;
+    LoadSimulation *clone() const override;
+    const string toString() const override;
+    void record(ActionJournal &journal) const override;
 
 private:
+    const string path;
 };
\ No newline at end of file
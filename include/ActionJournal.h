@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "SharedStore.h"
+
+// What a journal entry records; the order matches the verbs in ActionJournal.cpp
+enum class ActionCode : uint8_t
+{
+    STEP,
+    PLAN,
+    SETTLEMENT,
+    FACILITY,
+    PLAN_STATUS,
+    CHANGE_POLICY,
+    COMPARE,
+    AUTOTUNE,
+    LOG,
+    SOURCE,
+    CLOSE,
+    BACKUP,
+    RESTORE,
+    SAVE,
+    LOAD,
+    REWIND,
+};
+
+// One argument of a journal entry: a number, or text that the journal interns
+struct JournalArgument
+{
+    JournalArgument(int number) : text(nullptr), number(number) {}
+    JournalArgument(const std::string &text) : text(&text), number(0) {}
+
+    const std::string *text;
+    int number;
+};
+
+// An entry read back from a journal, owning its text
+struct JournalEntry
+{
+    struct Value
+    {
+        bool isText;
+        int number;
+        std::string text;
+    };
+
+    JournalEntry() : code(ActionCode::STEP), completed(true), errorMsg(), args() {}
+
+    std::string command() const; // The command line that ran it, e.g. "changePolicy 0 opt 7"
+
+    ActionCode code;
+    bool completed;
+    std::string errorMsg;
+    std::vector<Value> args;
+};
+
+/*
+The actions a simulation has run, packed into bytes and rendered only when printed. An entry is
+one byte for its code and outcome, then varints: the error message (if it failed) and the arguments,
+each a zigzag-encoded number or the index of an interned string, tagged with its kind and whether
+it is the last. A step or planStatus entry takes two or three bytes.
+
+Repeats of the same entry are folded into a single repeat count after it. Only the newest
+windowBytes stay in memory: past that, they are appended to a temporary file and read back
+in order by print(). Interned strings stay in memory.
+
+Copies share the entries (in memory and on disk) and each remembers how much of them it sees, so
+a backup is O(1) and restoring it drops whatever was appended since, as with SharedStore.
+*/
+class ActionJournal
+{
+public:
+    explicit ActionJournal(size_t windowBytes = 1 << 20);
+
+    void append(ActionCode code, bool completed, const std::string &errorMsg, std::initializer_list<JournalArgument> args);
+    void append(ActionCode code, bool completed, const std::string &errorMsg, const JournalArgument *args, size_t argCount);
+    void append(const JournalEntry &entry);
+    size_t size() const;        // Entries, counting each repeat
+    size_t byteSize() const;    // Of the packed entries, in memory and on disk, not counting interned strings
+    size_t spilledBytes() const; // Of those, how many are on disk
+    void print(std::ostream &out) const; // Every entry but "log", one per line, as the actions' toString() renders it
+    // The first count entries after those of earlier, an older copy of this journal
+    std::vector<JournalEntry> entriesAfter(const ActionJournal &earlier, size_t count) const;
+    // Stop sharing with copies that appended past this journal's view, as SharedStore::detach() does;
+    // the bytes this journal sees are copied. Throws if the spilled ones cannot be read back.
+    void detach();
+    void clear();
+
+private:
+    // The packed entries of a journal and its copies: [0, fileLength) on disk, then tail in memory
+    struct Data
+    {
+        Data();
+        Data(const Data &other) = delete;
+        Data &operator=(const Data &other) = delete;
+        ~Data();
+
+        int file; // -1 until the first spill
+        size_t fileLength;
+        std::vector<uint8_t> tail;
+    };
+
+    uint32_t intern(const std::string &text);
+    void write(const uint8_t *entry, size_t count);
+    void writeRepeats();
+    void truncate();
+    void spill(Data &target);
+    template <typename Visit>
+    void forEachBlock(size_t from, size_t to, Visit visit) const;
+    const uint8_t *render(const uint8_t *begin, const uint8_t *end, std::string &line, bool &shown, std::ostream &out) const;
+    void decode(const uint8_t *cursor, const uint8_t *end, JournalEntry &entry) const;
+
+    std::shared_ptr<Data> data;
+    size_t length; // Bytes of data this journal sees
+    SharedStore<std::string> strings; // Interned arguments and error messages, by index
+    size_t entries;
+    std::vector<uint8_t> lastEntry; // Encoded, for folding repeats of it
+    std::vector<uint8_t> encoded;   // Scratch for the entry being appended
+    uint32_t repeats;               // Times lastEntry happened again and is not written yet
+    size_t windowBytes;
+};
@@ -4,8 +4,21 @@
 #include <sstream>
 #include <string>
 
+// One argument of a line, pointing into the caller's buffer
+struct ArgumentView
+{
+    const char *begin;
+    size_t length;
+
+    bool operator==(const char *word) const;
+    bool operator!=(const char *word) const;
+    std::string str() const;
+};
+
 class Auxiliary
 {
 public:
     static std::vector<std::string> parseArguments(const std::string &line);
+    static int splitArguments(const char *begin, const char *end, ArgumentView *arguments, int maxArguments);
+    static bool parseInt(const ArgumentView &argument, int &value);
 };
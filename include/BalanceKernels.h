@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include "Facility.h"
+
+/*
+Scans for the most balanced type, exactly like BalancedSelection's original loop: the first type
+with the smallest max(|a - b|, |b - c|, |c - a|) over the totals a, b, c it would lead to, and only
+types below INT_MAX count. Each kernel takes positions [begin, end) and the best so far.
+*/
+typedef void (*BalanceKernel)(const FacilityColumns &columns, size_t begin, size_t end, int lifeQuality, int economy, int environment,
+                              int &bestGap, int &bestPosition);
+
+struct BalanceKernelEntry
+{
+    const char *name;
+    BalanceKernel scan;
+};
+
+// The kernels this CPU can run, scalar first and the widest last
+std::vector<BalanceKernelEntry> supportedBalanceKernels();
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include "Auxiliary.h"
+
+class BaseAction;
+
+// The REPL's commands, for Simulation::runCommand() and for replaying logged actions
+
+const int MAX_COMMAND_ARGUMENTS = 8; // One more than any command takes, so longer lines do not match
+
+// Room for any action, so a command's action can be built in place instead of on the heap
+typedef std::aligned_storage<256, alignof(std::max_align_t)>::type ActionStorage;
+
+// A REPL command: its verb, how many arguments it takes counting the verb, how to build its
+// action (nullptr when the arguments do not fit after all), and whether the action replaces the
+// simulation's state instead of changing it, which replay cannot redo
+struct Command
+{
+    const char *verb;
+    int argCount;
+    BaseAction *(*build)(const ArgumentView *args, void *storage);
+    bool replacesState;
+};
+
+// The command a split line names, or nullptr
+const Command *findCommand(const ArgumentView *args, int argCount);
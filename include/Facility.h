@@ -1,6 +1,9 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "Settlement.h"
 using std::string;
 using std::vector;
 
@@ -38,22 +41,97 @@ protected:
     const int environment_score;
 };
 
-class Facility : public FacilityType
+// The numbers of a catalog's types as contiguous columns (entry i belongs to type i)
+struct FacilityColumns
+{
+    const int *lifeQuality;
+    const int *economy;
+    const int *environment;
+    const int *price;
+    const int *category;
+    size_t size;
+};
+
+// The facility types a simulation offers. Besides the types themselves it keeps, for each
+// category, the positions of that category's types, so a policy can walk one category directly,
+// the types' numbers as columns for vectorized scans, and an index of the types by score
+// differences for finding the most balanced one in a large catalog.
+class FacilityCatalog
+{
+public:
+    typedef vector<FacilityType>::const_iterator const_iterator;
+
+    FacilityCatalog();
+    FacilityCatalog(const FacilityCatalog &other) = delete;
+    FacilityCatalog &operator=(const FacilityCatalog &other) = delete;
+    size_t size() const;
+    bool empty() const;
+    const FacilityType &operator[](size_t index) const;
+    const FacilityType *data() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const vector<int> &ofCategory(FacilityCategory category) const; // Ascending positions
+    FacilityColumns columns() const;
+    int mostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const;
+    unsigned long getVersion() const; // Changes whenever types does
+    void push_back(const FacilityType &type);
+    void pop_back();
+
+private:
+    vector<FacilityType> types;
+    // A type, by its (life quality - economy, economy - environment) score differences, and the
+    // bounding box and first catalog position of the subtree it heads in balanceTree
+    struct BalanceNode
+    {
+        long long x, y;
+        int position, minPosition;
+        long long minX, maxX, minY, maxY;
+    };
+
+    int scanMostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const;
+    void buildBalanceTree() const;
+    void buildBalanceTree(size_t begin, size_t end, bool splitOnX) const;
+    void searchBalanceTree(size_t begin, size_t end, bool splitOnX, long long targetX, long long targetY, long long &bestGap, int &bestPosition) const;
+
+    vector<int> categories[3]; // Indexed by FacilityCategory
+    vector<int> lifeQualityColumn, economyColumn, environmentColumn, priceColumn, categoryColumn;
+    // k-d tree over the distinct score differences, in an array (each range is headed by its middle
+    // node). It is rebuilt by the first search after the catalog changes; searches may run in parallel.
+    mutable vector<BalanceNode> balanceTree;
+    mutable std::mutex balanceTreeMutex;
+    mutable std::atomic<unsigned long> balanceTreeVersion;
+    unsigned long version; // Bumped by every change to types
+};
+
+// A facility being built by a plan. It only refers to its facilitiesOptions entry and its
+// settlement, so it is a small trivially copyable value with no heap allocation.
+class Facility
 {
 
 public:
-    Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score);
-    Facility(const FacilityType &type, const string &settlementName);
+    Facility(const FacilityCatalog &facilityOptions, int typeIndex, const Settlement &settlement);
+    Facility(const FacilityCatalog &facilityOptions, int typeIndex, const Settlement &settlement, int timeLeft);
+    const FacilityType &getType() const;
+    const string &getName() const;
+    int getCost() const;
+    int getLifeQualityScore() const;
+    int getEnvironmentScore() const;
+    int getEconomyScore() const;
+    FacilityCategory getCategory() const;
     const string &getSettlementName() const;
+    int getTypeIndex() const;
     const int getTimeLeft() const;
     FacilityStatus step();
+    FacilityStatus step(int ticks);
     Facility *clone() const;
     void setStatus(FacilityStatus status);
     const FacilityStatus &getStatus() const;
     const string toString() const;
 
 private:
-    const string settlementName;
+    const FacilityCatalog *facilityOptions;
+    int typeIndex; // Position of the type in facilityOptions
+    const Settlement *settlement;
     FacilityStatus status;
     int timeLeft;
 };
\ No newline at end of file
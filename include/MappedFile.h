@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Read-only contents of a whole file: memory-mapped when possible, read into a buffer otherwise
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+    ~MappedFile();
+
+    bool isOpen() const;
+    const char *data() const;
+    size_t size() const;
+
+private:
+    bool opened;
+    void *mapping;
+    size_t length;
+    std::vector<char> buffer; // Used when the file cannot be mapped (a pipe, for instance)
+};
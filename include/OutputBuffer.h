@@ -0,0 +1,26 @@
+#pragma once
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+// Takes over a stream's output for as long as it exists and collects it in one large buffer.
+// Flushes (std::endl) do not write; the buffer is written out when it fills, on drain(), and on destruction.
+class OutputBuffer : public std::streambuf
+{
+public:
+    explicit OutputBuffer(std::ostream &stream, size_t capacity = 1 << 20);
+    OutputBuffer(const OutputBuffer &other) = delete;
+    OutputBuffer &operator=(const OutputBuffer &other) = delete;
+    ~OutputBuffer();
+
+    void drain(); // Write out everything collected so far (a sync point)
+
+protected:
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+private:
+    std::ostream &stream;
+    std::streambuf *target; // The stream's own buffer, restored on destruction
+    std::vector<char> buffer;
+};
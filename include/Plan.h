@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include "Facility.h"
 #include "Settlement.h"
@@ -11,50 +12,103 @@ enum class PlanStatus
     BUSY,
 };
 
+// How many operational facilities a plan has of one facilitiesOptions entry
+struct FacilityCount
+{
+    int typeIndex;
+    int count;
+};
+
+// Lists a plan's operational facilities one by one without storing them individually
+class OperationalFacilities
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const OperationalFacilities &view, size_t entry);
+        const FacilityType &operator*() const;
+        Iterator &operator++();
+        bool operator!=(const Iterator &other) const;
+
+    private:
+        const OperationalFacilities *view;
+        size_t entry;
+        int repeat;
+    };
+
+    OperationalFacilities(const vector<FacilityCount> &counts, const FacilityCatalog &facilityOptions);
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+
+private:
+    const vector<FacilityCount> &counts;
+    const FacilityCatalog &facilityOptions;
+};
+
 class Plan
 {
 public:
     Plan(int id,
          const Settlement &settlement,
          SelectionPolicy *policy,
-         const std::vector<FacilityType> &facilityOptions,
+         PlanStatus status,
+         const FacilityCatalog &facilityOptions,
          int lifeQuality,
          int economy,
          int environment,
-         std::vector<Facility *> facilities,
-         std::vector<Facility *> underConstruction);
-    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
+         std::vector<FacilityCount> facilities,
+         std::vector<Facility> underConstruction);
+    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const FacilityCatalog &facilityOptions);
     // Rule of 5
     ~Plan();                            // Destructor
     Plan(const Plan &other);            // Copy Constructor
     Plan &operator=(const Plan &other); // Copy operator
     Plan(Plan &&other) noexcept;        // Move Constructor
 
-    Plan cloneDeep(const std::vector<Settlement *> &settlements, const std::vector<FacilityType> &facilitiesOptions) const;
-
     const int getlifeQualityScore() const;
     const int getEconomyScore() const;
     const int getEnvironmentScore() const;
     const int getPlanId() const;
-    const int getConstructionLimit();
+    const Settlement &getSettlement() const;
+    const int getConstructionLimit() const;
     PlanStatus getPlanStatus();
-    const string getSelectionPolicyType();
+    PlanStatus getStatus() const; // As of the last step, without recomputing it
+    const string getSelectionPolicyType() const;
 
     void setSelectionPolicy(SelectionPolicy *selectionPolicy);
     void step();
-    void printStatus();
+    void step(int numOfSteps);
+    void printStatus() const;
     void printShortStatus();
-    const vector<Facility *> &getFacilities() const;
-    void addFacility(Facility *facility);
+    OperationalFacilities getFacilities() const;
+    const vector<FacilityCount> &getFacilityCounts() const;
+    const vector<Facility> &getUnderConstruction() const;
+    const SelectionPolicy &getSelectionPolicy() const;
+    // A plan with this one's scores and facilities under construction, but no operational facilities, run by policy
+    std::shared_ptr<Plan> fork(SelectionPolicy *policy) const;
+    // Every policy the plan could be switched to, set up the way changePolicy would set it up, with look-ahead
+    // planning horizon steps. Where the plan already has that policy its own is cloned instead; ownIndex is
+    // where that is (its own policy is appended if it is none of them).
+    vector<SelectionPolicy *> policyCandidates(int horizon, int &ownIndex) const;
+    void addFacility(const Facility &facility);
     const string toString() const;
 
 private:
+    void step(vector<int> *completedTypes);
+    template <typename Policy>
+    void fillSlots(Policy &policy);
+    int idleSteps() const;
+    void addOperational(int typeIndex, int count);
+
     int plan_id;
     const Settlement &settlement;
     SelectionPolicy *selectionPolicy; // What happens if we change this to a reference?
     PlanStatus status;
-    vector<Facility *> facilities;
-    vector<Facility *> underConstruction;
-    const vector<FacilityType> &facilityOptions;
+    vector<FacilityCount> facilities; // Operational facilities per type, in order of first completion
+    vector<int> facilitySlots;        // typeIndex -> position in facilities, -1 if none yet
+    vector<Facility> underConstruction;
+    const FacilityCatalog &facilityOptions;
     int life_quality_score, economy_score, environment_score;
 };
\ No newline at end of file
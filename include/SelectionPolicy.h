@@ -3,23 +3,57 @@
 #include "Facility.h"
 using std::vector;
 
+// The closed set of policies. Callers switch on it to reach the concrete class without a virtual call.
+enum class PolicyKind
+{
+    NAIVE,
+    BALANCED,
+    ECONOMY,
+    SUSTAINABILITY,
+    LOOK_AHEAD,
+};
+
+// What "opt <horizon> [<lifeQualityWeight> <economyWeight> <environmentWeight>]" asks for; the weights default to 1
+struct LookAheadSettings
+{
+    int horizon;
+    int lifeQualityWeight, economyWeight, environmentWeight;
+};
+
 class SelectionPolicy
 {
 public:
-    virtual const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) = 0;
+    explicit SelectionPolicy(PolicyKind kind);
+    PolicyKind getKind() const { return kind; }
+    // The kind a policy name ("nve", "bal", "eco", "env", "opt <horizon> [<weights>]") stands for; false for an unknown
+    // name. settings is set for "opt"; otherwise its horizon is 0.
+    static bool kindOf(const string &name, PolicyKind &kind, LookAheadSettings &settings);
+    // A new policy of this kind; a balanced one starts from the given totals, a look-ahead one plans with settings
+    static SelectionPolicy *create(PolicyKind kind, int lifeQualityScore, int economyScore, int environmentScore, const LookAheadSettings &settings);
+    virtual const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) = 0;
+    // The next count picks at once, as catalog positions; the same as count selectFacility calls
+    virtual void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) = 0;
     virtual const string toString() const = 0;
     virtual SelectionPolicy *clone() const = 0;
     virtual ~SelectionPolicy() = default;
     virtual const string getPolicyType() const = 0;
+    // Where the next round-robin search starts in facilitiesOptions, or -1 when picks also depend on accumulated scores
+    virtual int getCursor() const = 0;
+
+private:
+    PolicyKind kind;
 };
 
-class NaiveSelection : public SelectionPolicy
+class NaiveSelection final : public SelectionPolicy
 {
 public:
     NaiveSelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    explicit NaiveSelection(int lastSelectedIndex);
+    const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) override;
     const string toString() const override;
     const string getPolicyType() const override;
+    int getCursor() const override;
     NaiveSelection *clone() const override;
     ~NaiveSelection() override = default;
 
@@ -27,13 +61,18 @@ private:
     int lastSelectedIndex;
 };
 
-class BalancedSelection : public SelectionPolicy
+class BalancedSelection final : public SelectionPolicy
 {
 public:
     BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) override;
+    int getLifeQualityScore() const;
+    int getEconomyScore() const;
+    int getEnvironmentScore() const;
     const string toString() const override;
     const string getPolicyType() const override;
+    int getCursor() const override;
     BalancedSelection *clone() const override;
     ~BalancedSelection() override = default;
 
@@ -43,30 +82,76 @@ private:
     int EnvironmentScore;
 };
 
-class EconomySelection : public SelectionPolicy
+class EconomySelection final : public SelectionPolicy
 {
 public:
     EconomySelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    explicit EconomySelection(int lastSelectedIndex);
+    const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) override;
     const string toString() const override;
     const string getPolicyType() const override;
+    int getCursor() const override;
     EconomySelection *clone() const override;
     ~EconomySelection() override = default;
 
 private:
     int lastSelectedIndex;
+    int nextCandidate; // Position in the catalog's list of this category, or -1 to look it up from lastSelectedIndex
 };
 
-class SustainabilitySelection : public SelectionPolicy
+class SustainabilitySelection final : public SelectionPolicy
 {
 public:
     SustainabilitySelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    explicit SustainabilitySelection(int lastSelectedIndex);
+    const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) override;
     const string toString() const override;
     const string getPolicyType() const override;
+    int getCursor() const override;
     SustainabilitySelection *clone() const override;
     ~SustainabilitySelection() override = default;
 
 private:
     int lastSelectedIndex;
-};
\ No newline at end of file
+    int nextCandidate; // Position in the catalog's list of this category, or -1 to look it up from lastSelectedIndex
+};
+
+// Picks what completes the most weighted life quality, economy and environment score within the next
+// horizon steps. A type takes its price in steps to build (at least one). Construction slots never share
+// anything, so the best schedule for the plan is the best one for each free slot on its own: the
+// best run of builds that fits in horizon steps. Those runs are memoized by the steps left, and only
+// types that no faster type beats are tried.
+class LookAheadSelection final : public SelectionPolicy
+{
+public:
+    explicit LookAheadSelection(const LookAheadSettings &settings);
+    LookAheadSelection(const LookAheadSelection &other);
+    LookAheadSelection &operator=(const LookAheadSelection &other) = delete;
+    const FacilityType &selectFacility(const FacilityCatalog &facilitiesOptions) override;
+    void selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions) override;
+    int getHorizon() const;
+    const LookAheadSettings &getSettings() const;
+    const string getPickTimes() const;
+    const string toString() const override;
+    const string getPolicyType() const override;
+    int getCursor() const override;
+    LookAheadSelection *clone() const override;
+    ~LookAheadSelection() override = default;
+
+    static const int MAX_HORIZON = 10000;
+    static const int MAX_WEIGHT = 1000;
+    // A horizon in 1..MAX_HORIZON and weights in 0..MAX_WEIGHT
+    static bool isValid(const LookAheadSettings &settings);
+
+private:
+    void planRuns(const FacilityCatalog &facilitiesOptions);
+
+    LookAheadSettings settings;
+    const FacilityCatalog *plannedCatalog; // What bestFirst was computed for
+    unsigned long plannedVersion;
+    int bestFirst; // The type that starts the best run
+    long pickCount;
+    double lastPickMicros, totalPickMicros;
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Append-only list that a simulation shares with its backups. Entries are never changed in place,
+// so a copy only remembers how many entries it can see. Assigning an older copy back (restore)
+// drops whatever was appended after that copy was taken. Container holds the entries; it needs
+// vector's push_back, pop_back, size, operator[] and begin.
+template <typename T, typename Container = std::vector<T>>
+class SharedStore
+{
+public:
+    typedef typename Container::const_iterator const_iterator;
+
+    SharedStore() : data(std::make_shared<Data>()), length(0) {}
+    SharedStore(const SharedStore &other) = default;
+
+    SharedStore &operator=(const SharedStore &other)
+    {
+        data = other.data;
+        length = other.length;
+        truncate();
+        return *this;
+    }
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const T &operator[](size_t index) const { return data->items[index]; }
+    const_iterator begin() const { return data->items.begin(); }
+    const_iterator end() const { return data->items.begin() + length; }
+
+    // The underlying container. It is exactly this store's view as long as no newer copy appended to it.
+    const Container &items() const { return data->items; }
+
+    void push_back(const T &value)
+    {
+        truncate();
+        data->items.push_back(value);
+        ++length;
+    }
+
+    // Append value under a unique name; returns false (and appends nothing) if the name is taken
+    bool add(const std::string &name, const T &value)
+    {
+        truncate();
+        auto inserted = data->index.insert(std::make_pair(name, static_cast<int>(length)));
+        if (!inserted.second)
+        {
+            return false;
+        }
+        data->items.push_back(value);
+        data->keys.push_back(std::make_pair(length, &inserted.first->first));
+        ++length;
+        return true;
+    }
+
+    // Position of the entry added under name, or -1
+    int find(const std::string &name) const
+    {
+        auto found = data->index.find(name);
+        return found == data->index.end() || found->second >= (int)length ? -1 : found->second;
+    }
+
+    void clear()
+    {
+        data = std::make_shared<Data>();
+        length = 0;
+    }
+
+    bool shares(const SharedStore &other) const { return data == other.data; }
+
+    // Stop sharing with copies that appended past this store's view, so appending here cannot drop what
+    // they see: the entries this store sees are copied. Not for a store whose container is referred to
+    // (the facility catalog plans hold), since those references would keep seeing the shared one.
+    void detach()
+    {
+        if (data->items.size() == length)
+        {
+            return;
+        }
+        std::shared_ptr<Data> copy = std::make_shared<Data>();
+        for (size_t i = 0; i < length; ++i)
+        {
+            copy->items.push_back(data->items[i]);
+        }
+        for (const auto &key : data->keys)
+        {
+            if (key.first >= length)
+            {
+                break; // Keys are in the order of their items
+            }
+            auto inserted = copy->index.insert(std::make_pair(*key.second, static_cast<int>(key.first)));
+            copy->keys.push_back(std::make_pair(key.first, &inserted.first->first));
+        }
+        data = copy;
+    }
+
+private:
+    struct Data
+    {
+        Data() : items(), index(), keys() {}
+
+        Container items;
+        std::unordered_map<std::string, int> index;
+        std::vector<std::pair<size_t, const std::string *>> keys; // Position and name (in index) of each item added under a name
+    };
+
+    // Forget entries a newer copy appended past this store's view
+    void truncate()
+    {
+        while (!data->keys.empty() && data->keys.back().first >= length)
+        {
+            data->index.erase(*data->keys.back().second);
+            data->keys.pop_back();
+        }
+        while (data->items.size() > length)
+        {
+            data->items.pop_back();
+        }
+    }
+
+    std::shared_ptr<Data> data;
+    size_t length;
+};
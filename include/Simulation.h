@@ -1,19 +1,25 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
+#include "ActionJournal.h"
 #include "Facility.h"
 #include "Plan.h"
 #include "Settlement.h"
+#include "SharedStore.h"
+#include "ThreadPool.h"
 using std::string;
 using std::vector;
 
 class BaseAction;
+class MappedFile;
 class SelectionPolicy;
 
 class Simulation
 {
 public:
     Simulation(const string &configFilePath);
+    Simulation(const string &configFilePath, int workerCount);
     Simulation(const Simulation &other);
     Simulation(Simulation &&other) noexcept;
     Simulation &operator=(const Simulation &other);
@@ -21,26 +27,62 @@ public:
     ~Simulation();
 
     void start();
+    void startBatch(const string &commandsPath);
+    long long runScript(const string &path);
     void addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
     void addAction(BaseAction *action);
     bool addSettlement(Settlement *settlement);
     bool addFacility(FacilityType facility);
     bool isSettlementExists(const string &settlementName);
     bool isPlanExists(const int planID);
+    int getPlanCount() const;
     Settlement &getSettlement(const string &settlementName);
     Plan &getPlan(const int planID);
-    const std::vector<BaseAction *> &getActionsLog() const;
+    const Plan &getPlan(const int planID) const;
+    const ActionJournal &getActionsLog() const;
     void step();
+    void step(int numOfSteps);
+    void rewind(int actionIndex);
+    void setWorkerCount(int workerCount);
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)> &task) const;
+    void saveSnapshot(const string &path) const;
+    void loadSnapshot(const string &path);
+    static void compileConfig(const string &configFilePath, const string &imagePath, int workerCount);
     void close();
     void open();
     void clear();
     Simulation *clone() const;
 
 private:
+    // A copy of the simulation after its first actionIndex actions, to rewind to
+    struct Checkpoint
+    {
+        size_t actionIndex;
+        bool barrier; // Taken after a restore, load or rewind; kept when checkpoints are thinned out
+        std::shared_ptr<const Simulation> state;
+    };
+
+    bool runCommand(const char *begin, const char *end);
+    void afterAction(bool replacedState);
+    void checkpoint(bool barrier);
+    void replay(const JournalEntry &entry, size_t actionIndex, std::unique_ptr<Simulation> &backup);
+    void detach();
+    void loadConfig(const string &configFilePath);
+    bool loadConfigImage(const MappedFile &image, const string &imagePath, string &sourcePath);
+    void writeSnapshot(const string &path, const string &source) const;
+    void restoreSnapshot(const MappedFile &file, const string &path);
+    static bool isSnapshot(const char *data, size_t size);
+    vector<std::shared_ptr<Plan>> &ownPlans();
+    Plan &ownPlan(int planID);
+
     bool isRunning;
     int planCounter; // For assigning unique plan IDs
-    vector<BaseAction *> actionsLog;
-    vector<Plan> plans;
-    vector<Settlement *> settlements;
-    vector<FacilityType> facilitiesOptions;
+    // Copies of a simulation (backups) share everything below; see SharedStore and ownPlans()
+    ActionJournal actionsLog;
+    std::shared_ptr<vector<std::shared_ptr<Plan>>> plans; // Copy-on-write: a plan is copied before it is changed
+    SharedStore<std::shared_ptr<Settlement>> settlements;         // Indexed by name
+    SharedStore<FacilityType, FacilityCatalog> facilitiesOptions; // Indexed by name
+    std::shared_ptr<ThreadPool> workerPool;                       // Used by step() and loadConfig()
+    vector<Checkpoint> checkpoints;                               // By actionIndex; not copied, a copy has no history
+    size_t checkpointInterval;
 };
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads used to split independent work (e.g. plans) into chunks.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int workerCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    int size() const;
+    // Runs task(begin, end) over contiguous chunks of [0, count); the calling thread takes part and blocks until all chunks are done.
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)> &task);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    const std::function<void(size_t, size_t)> *task;
+    size_t count;
+    size_t chunkSize;
+    size_t nextChunk;
+    int activeWorkers;
+    unsigned long generation;
+    bool stopping;
+    std::exception_ptr failure;
+};
@@ -3,8 +3,13 @@
 #include "SelectionPolicy.h"
 #include "Plan.h"
 #include <string>
+#include <stdexcept>
 #include <iostream>
-#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
 
 BaseAction::BaseAction() : errorMsg(""), status(ActionStatus::ERROR) {}
 
@@ -34,10 +39,7 @@ SimulateStep::SimulateStep(const int numOfSteps) : numOfSteps(numOfSteps) {}
 
 void SimulateStep::act(Simulation &simulation)
 {
-    for (int i = 0; i < numOfSteps; i++)
-    {
-        simulation.step();
-    }
+    simulation.step(numOfSteps);
     complete();
 }
 
@@ -53,6 +55,11 @@ const string SimulateStep::toString() const
     }
 }
 
+void SimulateStep::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::STEP, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {numOfSteps});
+}
+
 SimulateStep *SimulateStep::clone() const
 {
     return new SimulateStep(numOfSteps);
@@ -66,21 +73,11 @@ void AddPlan::act(Simulation &simulation)
     {
         Settlement &settlement = simulation.getSettlement(settlementName);
         SelectionPolicy *policy = nullptr;
-        if (selectionPolicy == "nve")
-        {
-            policy = new NaiveSelection();
-        }
-        else if (selectionPolicy == "bal")
+        PolicyKind kind;
+        LookAheadSettings settings;
+        if (SelectionPolicy::kindOf(selectionPolicy, kind, settings))
         {
-            policy = new BalancedSelection(0, 0, 0);
-        }
-        else if (selectionPolicy == "eco")
-        {
-            policy = new EconomySelection();
-        }
-        else if (selectionPolicy == "env")
-        {
-            policy = new SustainabilitySelection();
+            policy = SelectionPolicy::create(kind, 0, 0, 0, settings);
         }
         else
         {
@@ -107,6 +104,11 @@ const string AddPlan::toString() const
     }
 }
 
+void AddPlan::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::PLAN, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {settlementName, selectionPolicy});
+}
+
 AddPlan *AddPlan::clone() const
 {
     return new AddPlan(*this);
@@ -145,6 +147,11 @@ const std::string AddSettlement::toString() const
     }
 }
 
+void AddSettlement::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::SETTLEMENT, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {settlementName, static_cast<int>(settlementType)});
+}
+
 PrintPlanStatus::PrintPlanStatus(int planId) : planId(planId) {}
 
 void PrintPlanStatus::act(Simulation &simulation)
@@ -154,8 +161,8 @@ void PrintPlanStatus::act(Simulation &simulation)
         error("Plan doesn’t exist");
         return;
     }
-    Plan plan = simulation.getPlan(planId);
-    plan.printStatus();
+    const Simulation &view = simulation; // Reading the plan must not take it over from a backup
+    view.getPlan(planId).printStatus();
 
     complete(); // Mark action as completed
 }
@@ -177,6 +184,11 @@ const string PrintPlanStatus::toString() const
     }
 }
 
+void PrintPlanStatus::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::PLAN_STATUS, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {planId});
+}
+
 ChangePlanPolicy::ChangePlanPolicy(const int planId, const string &newPolicy) : planId(planId), newPolicy(newPolicy) {}
 
 void ChangePlanPolicy::act(Simulation &simulation)
@@ -186,37 +198,24 @@ void ChangePlanPolicy::act(Simulation &simulation)
         error("Cannot change selection policy");
         return;
     }
-    Plan plan = simulation.getPlan(planId);
-    SelectionPolicy *newSelectionPolicy = nullptr;
-
-    if (newPolicy == "nev")
-    {
-        newSelectionPolicy = new NaiveSelection();
-    }
-    else if (newPolicy == "eco")
-    {
-        newSelectionPolicy = new EconomySelection();
-    }
-    else if (newPolicy == "env")
-    {
-        newSelectionPolicy = new SustainabilitySelection();
-    }
-    else if (newPolicy == "bal")
-    {
-        newSelectionPolicy = new BalancedSelection(plan.getlifeQualityScore(), plan.getEconomyScore(), plan.getEnvironmentScore());
-    }
-    else
+    const Simulation &view = simulation; // Only the plan that actually changes is taken over from a backup
+    const Plan &current = view.getPlan(planId);
+    // changePolicy has always spelled the naive policy "nev"
+    PolicyKind kind = PolicyKind::NAIVE;
+    LookAheadSettings settings = LookAheadSettings{0, 1, 1, 1};
+    if (newPolicy != "nev" && (!SelectionPolicy::kindOf(newPolicy, kind, settings) || kind == PolicyKind::NAIVE))
     {
         error("Cannot change selection policy");
         return;
     }
-    if (plan.getSelectionPolicyType() == newSelectionPolicy->toString())
+    SelectionPolicy *newSelectionPolicy = SelectionPolicy::create(kind, current.getlifeQualityScore(), current.getEconomyScore(), current.getEnvironmentScore(), settings);
+    if (current.getSelectionPolicyType() == newSelectionPolicy->toString())
     {
         delete newSelectionPolicy;
         error("Cannot change selection policy");
         return;
     }
-    plan.setSelectionPolicy(newSelectionPolicy);
+    simulation.getPlan(planId).setSelectionPolicy(newSelectionPolicy);
 
     complete(); // Mark action as completed
 }
@@ -238,6 +237,88 @@ const std::string ChangePlanPolicy::toString() const
     }
 }
 
+void ChangePlanPolicy::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::CHANGE_POLICY, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {planId, newPolicy});
+}
+
+RewindSimulation::RewindSimulation(const int actionIndex) : actionIndex(actionIndex) {}
+
+void RewindSimulation::act(Simulation &simulation)
+{
+    try
+    {
+        simulation.rewind(actionIndex);
+    }
+    catch (const std::runtime_error &e)
+    {
+        error(e.what());
+        return;
+    }
+    complete();
+}
+
+RewindSimulation *RewindSimulation::clone() const
+{
+    return new RewindSimulation(*this);
+}
+
+const string RewindSimulation::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "rewind " + std::to_string(actionIndex) + " COMPLETED";
+    }
+    else
+    {
+        return "rewind " + std::to_string(actionIndex) + " ERROR: " + getErrorMsg();
+    }
+}
+
+void RewindSimulation::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::REWIND, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {actionIndex});
+}
+
+SourceCommands::SourceCommands(const string &path) : path(path) {}
+
+// Run every command in the file, each logged as its own action, then this one
+void SourceCommands::act(Simulation &simulation)
+{
+    try
+    {
+        simulation.runScript(path);
+    }
+    catch (const std::runtime_error &e)
+    {
+        error(e.what());
+        return;
+    }
+    complete();
+}
+
+SourceCommands *SourceCommands::clone() const
+{
+    return new SourceCommands(*this);
+}
+
+const string SourceCommands::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "source " + path + " COMPLETED";
+    }
+    else
+    {
+        return "source " + path + " ERROR: " + getErrorMsg();
+    }
+}
+
+void SourceCommands::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::SOURCE, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {path});
+}
+
 Close::Close() {}
 
 void Close::act(Simulation &simulation)
@@ -259,6 +340,11 @@ const string Close::toString() const
     return "close COMPLETED";
 }
 
+void Close::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::CLOSE, true, getErrorMsg(), {});
+}
+
 AddFacility::AddFacility(const string &facilityName, const FacilityCategory facilityCategory, const int price, const int lifeQualityScore, const int economyScore, const int environmentScore) : facilityName(facilityName), facilityCategory(facilityCategory), price(price), lifeQualityScore(lifeQualityScore), economyScore(economyScore), environmentScore(environmentScore) {}
 
 void AddFacility::act(Simulation &simulation)
@@ -295,6 +381,12 @@ const std::string AddFacility::toString() const
     }
 }
 
+void AddFacility::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::FACILITY, getStatus() == ActionStatus::COMPLETED, getErrorMsg(),
+                   {facilityName, static_cast<int>(facilityCategory), price, lifeQualityScore, economyScore, environmentScore});
+}
+
 BackupSimulation::BackupSimulation() {}
 
 void BackupSimulation::act(Simulation &simulation)
@@ -317,6 +409,11 @@ const string BackupSimulation::toString() const
     return "backup COMPLETED";
 }
 
+void BackupSimulation::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::BACKUP, true, getErrorMsg(), {});
+}
+
 RestoreSimulation::RestoreSimulation() {}
 
 void RestoreSimulation::act(Simulation &simulation)
@@ -348,19 +445,251 @@ const std::string RestoreSimulation::toString() const
     }
 }
 
-PrintActionsLog::PrintActionsLog() {}
+void RestoreSimulation::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::RESTORE, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {});
+}
 
-void PrintActionsLog::act(Simulation &simulation)
+namespace
+{
+    // Step forks [begin, end), noting the error of any whose policy fails
+    void stepForks(std::vector<std::shared_ptr<Plan>> &forks, size_t begin, size_t end, int numOfSteps, std::vector<string> &errors)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            try
+            {
+                forks[i]->step(numOfSteps);
+            }
+            catch (const std::runtime_error &e)
+            {
+                errors[i] = e.what();
+            }
+        }
+    }
+
+    // How autotune ranks a plan's scores: by the smallest of the three, or by a weighted sum
+    struct Objective
+    {
+        bool smallest;
+        long long lifeQualityWeight, economyWeight, environmentWeight;
+
+        long long score(const Plan &plan) const
+        {
+            if (smallest)
+            {
+                return std::min(plan.getlifeQualityScore(), std::min(plan.getEconomyScore(), plan.getEnvironmentScore()));
+            }
+            return lifeQualityWeight * plan.getlifeQualityScore() + economyWeight * plan.getEconomyScore() + environmentWeight * plan.getEnvironmentScore();
+        }
+    };
+
+    // "min", "sum", "life", "eco", "env", or weights "<lifeQuality>,<economy>,<environment>"
+    bool parseObjective(const string &name, Objective &objective)
+    {
+        objective = Objective{name == "min", name == "sum" || name == "life", name == "sum" || name == "eco", name == "sum" || name == "env"};
+        if (name == "min" || name == "sum" || name == "life" || name == "eco" || name == "env")
+        {
+            return true;
+        }
+        int consumed = 0;
+        return std::sscanf(name.c_str(), "%lld,%lld,%lld%n", &objective.lifeQualityWeight, &objective.economyWeight, &objective.environmentWeight, &consumed) == 3 &&
+               consumed == (int)name.size();
+    }
+}
+
+ComparePolicies::ComparePolicies(const int planId, const int numOfSteps) : planId(planId), numOfSteps(numOfSteps) {}
+
+void ComparePolicies::act(Simulation &simulation)
+{
+    if (!simulation.isPlanExists(planId) || numOfSteps < 0)
+    {
+        error("Cannot compare policies");
+        return;
+    }
+    const Simulation &view = simulation; // Reading the plan must not take it over from a backup
+    const Plan &plan = view.getPlan(planId);
+
+    int currentRow;
+    std::vector<SelectionPolicy *> policies = plan.policyCandidates(std::max(1, std::min(numOfSteps, LookAheadSelection::MAX_HORIZON)), currentRow);
+    std::vector<std::shared_ptr<Plan>> forks;
+    for (SelectionPolicy *policy : policies)
+    {
+        forks.push_back(plan.fork(policy));
+    }
+    std::vector<string> errors(forks.size());
+    view.parallelFor(forks.size(), [&](size_t begin, size_t end)
+                     { stepForks(forks, begin, end, numOfSteps, errors); });
+
+    std::cout << "Plan " << planId << " after " << numOfSteps << " steps (* = current policy):" << std::endl;
+    std::cout << std::left << std::setw(10) << "Policy" << std::right << std::setw(14) << "LifeQuality" << std::setw(14) << "Economy" << std::setw(14) << "Environment"
+         << std::setw(14) << "Total" << std::setw(10) << "Built" << std::endl;
+    for (size_t i = 0; i < forks.size(); ++i)
+    {
+        const Plan &fork = *forks[i];
+        string label = fork.getSelectionPolicy().toString() + ((int)i == currentRow ? " *" : "");
+        int built = 0;
+        for (const FacilityCount &count : fork.getFacilityCounts())
+        {
+            built += count.count;
+        }
+        std::cout << std::left << std::setw(10) << label << std::right << std::setw(14) << fork.getlifeQualityScore() << std::setw(14) << fork.getEconomyScore()
+             << std::setw(14) << fork.getEnvironmentScore()
+             << std::setw(14) << (long long)fork.getlifeQualityScore() + fork.getEconomyScore() + fork.getEnvironmentScore() << std::setw(10) << built;
+        if (!errors[i].empty())
+        {
+            std::cout << "  ERROR: " << errors[i];
+        }
+        std::cout << std::endl;
+    }
+
+    complete();
+}
+
+ComparePolicies *ComparePolicies::clone() const
+{
+    return new ComparePolicies(*this);
+}
+
+const string ComparePolicies::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "compare " + std::to_string(planId) + " " + std::to_string(numOfSteps) + " COMPLETED";
+    }
+    else
+    {
+        return "compare " + std::to_string(planId) + " " + std::to_string(numOfSteps) + " ERROR: " + getErrorMsg();
+    }
+}
+
+void ComparePolicies::record(ActionJournal &journal) const
 {
-    const std::vector<BaseAction *> &actionsLog = simulation.getActionsLog();
+    journal.append(ActionCode::COMPARE, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {planId, numOfSteps});
+}
+
+AutotunePolicies::AutotunePolicies(const int numOfSteps, const string &objective) : numOfSteps(numOfSteps), objective(objective) {}
 
-    for (const BaseAction *action : actionsLog)
+void AutotunePolicies::act(Simulation &simulation)
+{
+    Objective ranking;
+    if (numOfSteps < 0 || !parseObjective(objective, ranking))
     {
-        if (action->toString() != "log COMPLETED")
+        error("Cannot autotune policies");
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // What each plan would switch to: the candidate that ranks best after numOfSteps, kept unstepped.
+    // Its own policy wins ties, so a plan only changes for a strictly better outcome.
+    struct Decision
+    {
+        SelectionPolicy *policy; // nullptr to keep the plan's own
+        long long before, after;
+        bool failed;             // Every candidate's policy failed
+    };
+    const Simulation &view = simulation; // Plans are only read until the decisions are made
+    int planCount = view.getPlanCount();
+    std::vector<Decision> decisions(planCount, Decision{nullptr, 0, 0, false});
+    int horizon = std::max(1, std::min(numOfSteps, LookAheadSelection::MAX_HORIZON));
+    view.parallelFor(planCount, [&](size_t begin, size_t end)
+                     {
+        for (size_t p = begin; p < end; ++p)
+        {
+            const Plan &plan = view.getPlan(static_cast<int>(p));
+            int own;
+            std::vector<SelectionPolicy *> policies = plan.policyCandidates(horizon, own);
+            std::vector<std::shared_ptr<Plan>> forks;
+            for (SelectionPolicy *policy : policies)
+            {
+                forks.push_back(plan.fork(policy->clone()));
+            }
+            std::vector<string> errors(forks.size());
+            stepForks(forks, 0, forks.size(), numOfSteps, errors);
+
+            // The plan's own policy goes first, so another has to do strictly better
+            int best = errors[own].empty() ? own : -1;
+            long long bestScore = best < 0 ? 0 : ranking.score(*forks[own]);
+            decisions[p].before = bestScore;
+            for (size_t i = 0; i < forks.size(); ++i)
+            {
+                if (errors[i].empty() && (best < 0 || ranking.score(*forks[i]) > bestScore))
+                {
+                    best = static_cast<int>(i);
+                    bestScore = ranking.score(*forks[i]);
+                }
+            }
+            decisions[p].after = bestScore;
+            decisions[p].failed = best < 0;
+            for (size_t i = 0; i < policies.size(); ++i)
+            {
+                if ((int)i == best && best != own)
+                {
+                    decisions[p].policy = policies[i];
+                }
+                else
+                {
+                    delete policies[i];
+                }
+            }
+        } });
+
+    int changed = 0;
+    for (int p = 0; p < planCount; ++p)
+    {
+        const Decision &decision = decisions[p];
+        std::cout << "Plan " << p << ": ";
+        if (decision.failed)
+        {
+            std::cout << view.getPlan(p).getSelectionPolicy().toString() << " kept, every policy failed\n";
+        }
+        else if (decision.policy)
         {
-            std::cout << action->toString() << std::endl;
+            Plan &plan = simulation.getPlan(p);
+            std::cout << plan.getSelectionPolicy().toString() << " -> " << decision.policy->toString() << " (" << objective << " "
+                      << decision.before << " -> " << decision.after << ")\n";
+            plan.setSelectionPolicy(decision.policy);
+            ++changed;
+        }
+        else
+        {
+            std::cout << view.getPlan(p).getSelectionPolicy().toString() << " kept (" << objective << " " << decision.after << ")\n";
         }
     }
+    std::ostringstream elapsed;
+    elapsed << std::fixed << std::setprecision(1) << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Autotuned " << planCount << " plans, " << changed << " changed, in " << elapsed.str() << " ms" << std::endl;
+
+    complete();
+}
+
+AutotunePolicies *AutotunePolicies::clone() const
+{
+    return new AutotunePolicies(*this);
+}
+
+const string AutotunePolicies::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "autotune " + std::to_string(numOfSteps) + " " + objective + " COMPLETED";
+    }
+    else
+    {
+        return "autotune " + std::to_string(numOfSteps) + " " + objective + " ERROR: " + getErrorMsg();
+    }
+}
+
+void AutotunePolicies::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::AUTOTUNE, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {numOfSteps, objective});
+}
+
+PrintActionsLog::PrintActionsLog() {}
+
+void PrintActionsLog::act(Simulation &simulation)
+{
+    simulation.getActionsLog().print(std::cout);
     complete();
 }
 
@@ -372,4 +701,84 @@ PrintActionsLog *PrintActionsLog::clone() const
 const std::string PrintActionsLog::toString() const
 {
     return "log COMPLETED";
-}
\ No newline at end of file
+}
+
+void PrintActionsLog::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::LOG, true, getErrorMsg(), {});
+}
+SaveSimulation::SaveSimulation(const string &path) : path(path) {}
+
+void SaveSimulation::act(Simulation &simulation)
+{
+    try
+    {
+        simulation.saveSnapshot(path);
+    }
+    catch (const std::runtime_error &e)
+    {
+        error(e.what());
+        return;
+    }
+    complete();
+}
+
+SaveSimulation *SaveSimulation::clone() const
+{
+    return new SaveSimulation(*this);
+}
+
+const string SaveSimulation::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "save " + path + " COMPLETED";
+    }
+    else
+    {
+        return "save " + path + " ERROR: " + getErrorMsg();
+    }
+}
+
+void SaveSimulation::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::SAVE, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {path});
+}
+
+LoadSimulation::LoadSimulation(const string &path) : path(path) {}
+
+void LoadSimulation::act(Simulation &simulation)
+{
+    try
+    {
+        simulation.loadSnapshot(path);
+    }
+    catch (const std::runtime_error &e)
+    {
+        error(e.what());
+        return;
+    }
+    complete();
+}
+
+LoadSimulation *LoadSimulation::clone() const
+{
+    return new LoadSimulation(*this);
+}
+
+const string LoadSimulation::toString() const
+{
+    if (getStatus() == ActionStatus::COMPLETED)
+    {
+        return "load " + path + " COMPLETED";
+    }
+    else
+    {
+        return "load " + path + " ERROR: " + getErrorMsg();
+    }
+}
+
+void LoadSimulation::record(ActionJournal &journal) const
+{
+    journal.append(ActionCode::LOAD, getStatus() == ActionStatus::COMPLETED, getErrorMsg(), {path});
+}
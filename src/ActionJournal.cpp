@@ -0,0 +1,488 @@
+#include "ActionJournal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace
+{
+    // The verb each ActionCode renders as
+    const char *const verbs[] = {"step", "plan", "settlement", "facility", "planStatus", "changePolicy", "compare", "autotune",
+                                 "log", "source", "close", "backup", "restore", "save", "load", "rewind"};
+
+    const uint8_t FAILED = 0x80;  // Set in an entry's first byte when the action failed
+    const uint8_t NO_ARGS = 0x1;  // Set in an entry's first byte when it has no arguments
+    const uint8_t REPEAT = 0x7e;  // First byte of a repeat count rather than an entry
+    const uint8_t TEXT = 0x1;     // Set in an argument's varint when it is an interned string
+    const uint8_t LAST_ARG = 0x2; // Set in the last argument's varint
+
+    // Numbers are stored zigzag-encoded, so small negative ones stay short
+    uint32_t zigzag(int number)
+    {
+        return (static_cast<uint32_t>(number) << 1) ^ static_cast<uint32_t>(number >> 31);
+    }
+
+    int unzigzag(uint64_t value)
+    {
+        uint32_t encoded = static_cast<uint32_t>(value);
+        return static_cast<int>((encoded >> 1) ^ (0u - (encoded & 1)));
+    }
+
+    // Encode value into out (at most 10 bytes) and return its length
+    size_t putVarint(uint8_t *out, uint64_t value)
+    {
+        size_t length = 0;
+        while (value >= 0x80)
+        {
+            out[length++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        out[length++] = static_cast<uint8_t>(value);
+        return length;
+    }
+
+    void appendVarint(std::vector<uint8_t> &bytes, uint64_t value)
+    {
+        uint8_t encoded[10];
+        bytes.insert(bytes.end(), encoded, encoded + putVarint(encoded, value));
+    }
+
+    uint64_t readVarint(const uint8_t *&cursor)
+    {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            uint8_t byte = *cursor++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+    }
+
+    // Past the varint at cursor, or nullptr if it does not end before end
+    const uint8_t *skipVarint(const uint8_t *cursor, const uint8_t *end)
+    {
+        while (cursor < end && (*cursor & 0x80))
+        {
+            ++cursor;
+        }
+        return cursor < end ? cursor + 1 : nullptr;
+    }
+
+    // Past the entry or repeat count at cursor, or nullptr if it does not end before end
+    const uint8_t *skipEntry(const uint8_t *cursor, const uint8_t *end)
+    {
+        if (cursor == end)
+        {
+            return nullptr;
+        }
+        uint8_t head = *cursor++;
+        if (head == REPEAT || (head & FAILED))
+        {
+            cursor = skipVarint(cursor, end);
+        }
+        if (head == REPEAT || (head & NO_ARGS))
+        {
+            return cursor;
+        }
+        bool last = false;
+        while (cursor && !last)
+        {
+            const uint8_t *next = skipVarint(cursor, end);
+            last = next && (*cursor & LAST_ARG);
+            cursor = next;
+        }
+        return cursor;
+    }
+}
+
+ActionJournal::Data::Data() : file(-1), fileLength(0), tail() {}
+
+ActionJournal::Data::~Data()
+{
+    if (file >= 0)
+    {
+        close(file);
+    }
+}
+
+ActionJournal::ActionJournal(size_t windowBytes)
+    : data(std::make_shared<Data>()), length(0), strings(), entries(0), lastEntry(), encoded(), repeats(0), windowBytes(windowBytes) {}
+
+void ActionJournal::append(ActionCode code, bool completed, const std::string &errorMsg, std::initializer_list<JournalArgument> args)
+{
+    append(code, completed, errorMsg, args.begin(), args.size());
+}
+
+void ActionJournal::append(ActionCode code, bool completed, const std::string &errorMsg, const JournalArgument *args, size_t argCount)
+{
+    // Arguments carry their kind and whether they are the last one in their two low bits, so
+    // entries need no argument count
+    encoded.clear();
+    encoded.push_back(static_cast<uint8_t>(static_cast<uint8_t>(code) << 1 | (argCount == 0 ? NO_ARGS : 0) | (completed ? 0 : FAILED)));
+    if (!completed)
+    {
+        appendVarint(encoded, intern(errorMsg));
+    }
+    for (size_t i = 0; i < argCount; ++i)
+    {
+        const JournalArgument &arg = args[i];
+        uint64_t value = arg.text ? intern(*arg.text) : zigzag(arg.number);
+        appendVarint(encoded, value << 2 | (arg.text ? TEXT : 0) | (i + 1 == argCount ? LAST_ARG : 0));
+    }
+    ++entries;
+
+    if (encoded == lastEntry && repeats < UINT32_MAX)
+    {
+        ++repeats;
+        return;
+    }
+    writeRepeats();
+    write(encoded.data(), encoded.size());
+    lastEntry.swap(encoded);
+}
+
+// Append an entry read back from a journal
+void ActionJournal::append(const JournalEntry &entry)
+{
+    std::vector<JournalArgument> args;
+    args.reserve(entry.args.size());
+    for (const JournalEntry::Value &value : entry.args)
+    {
+        args.push_back(value.isText ? JournalArgument(value.text) : JournalArgument(value.number));
+    }
+    append(entry.code, entry.completed, entry.errorMsg, args.data(), args.size());
+}
+
+size_t ActionJournal::size() const
+{
+    return entries;
+}
+
+size_t ActionJournal::byteSize() const
+{
+    return length;
+}
+
+size_t ActionJournal::spilledBytes() const
+{
+    return std::min(length, data->fileLength);
+}
+
+// Call visit(begin, end) on the packed bytes [from, to): the spilled ones read back in blocks, then
+// the ones in memory. visit returns where the entry cut off by the end of a block starts, or nullptr to stop.
+template <typename Visit>
+void ActionJournal::forEachBlock(size_t from, size_t to, Visit visit) const
+{
+    size_t onDisk = std::min(to, data->fileLength);
+    if (from < onDisk)
+    {
+        std::vector<uint8_t> block(1 << 20);
+        size_t kept = 0; // Bytes of an unfinished entry at the start of block
+        size_t offset = from;
+        while (offset < onDisk)
+        {
+            ssize_t count = pread(data->file, block.data() + kept, std::min(block.size() - kept, onDisk - offset), static_cast<off_t>(offset));
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                break; // The file is gone or shorter than written; go on with what is in memory
+            }
+            offset += static_cast<size_t>(count);
+            const uint8_t *blockEnd = block.data() + kept + count;
+            const uint8_t *rest = visit(block.data(), blockEnd);
+            if (rest == nullptr)
+            {
+                return;
+            }
+            kept = blockEnd - rest;
+            std::copy(rest, blockEnd, block.begin());
+        }
+        from = onDisk; // Spills end on an entry boundary
+    }
+    if (to > from)
+    {
+        visit(data->tail.data() + (from - data->fileLength), data->tail.data() + (to - data->fileLength));
+    }
+}
+
+// Print the spilled entries, then the ones in memory, then the pending repeats
+void ActionJournal::print(std::ostream &out) const
+{
+    std::string line; // The last entry rendered, for its repeats
+    bool shown = false;
+    forEachBlock(0, length, [&](const uint8_t *begin, const uint8_t *end)
+                 { return render(begin, end, line, shown, out); });
+    for (uint32_t i = 0; shown && i < repeats; ++i)
+    {
+        out << line;
+    }
+    out.flush();
+}
+
+// Read entries back from the bytes earlier had not written yet. Its pending repeats are already
+// counted in earlier, so they are taken off the first repeat count that follows.
+std::vector<JournalEntry> ActionJournal::entriesAfter(const ActionJournal &earlier, size_t count) const
+{
+    std::vector<JournalEntry> result;
+    JournalEntry last;
+    if (!earlier.lastEntry.empty())
+    {
+        decode(earlier.lastEntry.data(), earlier.lastEntry.data() + earlier.lastEntry.size(), last);
+    }
+    uint64_t counted = earlier.repeats;
+    auto take = [&](uint64_t times)
+    {
+        for (; times > 0 && result.size() < count; --times)
+        {
+            result.push_back(last);
+        }
+    };
+
+    forEachBlock(earlier.length, length, [&](const uint8_t *begin, const uint8_t *end) -> const uint8_t *
+                 {
+        const uint8_t *cursor = begin;
+        while (result.size() < count)
+        {
+            const uint8_t *entryEnd = skipEntry(cursor, end);
+            if (entryEnd == nullptr)
+            {
+                return cursor;
+            }
+            if (*cursor == REPEAT)
+            {
+                const uint8_t *value = cursor + 1;
+                uint64_t repeated = readVarint(value);
+                take(repeated - std::min(repeated, counted));
+            }
+            else
+            {
+                decode(cursor, entryEnd, last);
+                take(1);
+            }
+            counted = 0;
+            cursor = entryEnd;
+        }
+        return nullptr; });
+
+    take(repeats - std::min<uint64_t>(repeats, counted));
+    return result;
+}
+
+// Print the whole entries in [begin, end) and return where the unfinished one starts
+const uint8_t *ActionJournal::render(const uint8_t *begin, const uint8_t *end, std::string &line, bool &shown, std::ostream &out) const
+{
+    const uint8_t *cursor = begin;
+    while (const uint8_t *entryEnd = skipEntry(cursor, end))
+    {
+        uint8_t head = *cursor++;
+        if (head == REPEAT)
+        {
+            for (uint64_t count = readVarint(cursor); shown && count > 0; --count)
+            {
+                out << line;
+            }
+            cursor = entryEnd;
+            continue;
+        }
+
+        ActionCode code = static_cast<ActionCode>((head & ~FAILED) >> 1);
+        const std::string *errorMsg = (head & FAILED) ? &strings[static_cast<size_t>(readVarint(cursor))] : nullptr;
+        shown = code != ActionCode::LOG;
+        if (!shown)
+        {
+            cursor = entryEnd;
+            continue;
+        }
+        line = verbs[static_cast<int>(code)];
+        while (cursor < entryEnd)
+        {
+            uint64_t value = readVarint(cursor);
+            line += ' ';
+            if (value & TEXT)
+            {
+                line += strings[static_cast<size_t>(value >> 2)];
+            }
+            else
+            {
+                line += std::to_string(unzigzag(value >> 2));
+            }
+        }
+        if (errorMsg)
+        {
+            line += " ERROR: ";
+            line += *errorMsg;
+            line += '\n';
+        }
+        else
+        {
+            line += " COMPLETED\n";
+        }
+        out << line;
+    }
+    return cursor;
+}
+
+// Decode the entry in [cursor, end)
+void ActionJournal::decode(const uint8_t *cursor, const uint8_t *end, JournalEntry &entry) const
+{
+    uint8_t head = *cursor++;
+    entry.code = static_cast<ActionCode>((head & ~FAILED) >> 1);
+    entry.completed = !(head & FAILED);
+    entry.errorMsg.clear();
+    if (!entry.completed)
+    {
+        entry.errorMsg = strings[static_cast<size_t>(readVarint(cursor))];
+    }
+    entry.args.clear();
+    while (cursor < end)
+    {
+        uint64_t value = readVarint(cursor);
+        JournalEntry::Value arg = {(value & TEXT) != 0, 0, std::string()};
+        if (arg.isText)
+        {
+            arg.text = strings[static_cast<size_t>(value >> 2)];
+        }
+        else
+        {
+            arg.number = unzigzag(value >> 2);
+        }
+        entry.args.push_back(arg);
+    }
+}
+
+std::string JournalEntry::command() const
+{
+    std::string line = verbs[static_cast<int>(code)];
+    for (const Value &arg : args)
+    {
+        line += ' ';
+        line += arg.isText ? arg.text : std::to_string(arg.number);
+    }
+    return line;
+}
+
+void ActionJournal::detach()
+{
+    strings.detach();
+    if (data->fileLength + data->tail.size() == length)
+    {
+        return;
+    }
+    std::shared_ptr<Data> copy = std::make_shared<Data>();
+    forEachBlock(0, length, [&](const uint8_t *begin, const uint8_t *end) -> const uint8_t *
+                 {
+        copy->tail.insert(copy->tail.end(), begin, end);
+        if (copy->tail.size() >= windowBytes)
+        {
+            spill(*copy);
+        }
+        return end; });
+    if (copy->fileLength + copy->tail.size() != length)
+    {
+        throw std::runtime_error("Cannot read the actions log back");
+    }
+    data = copy;
+}
+
+void ActionJournal::clear()
+{
+    data = std::make_shared<Data>();
+    length = 0;
+    strings.clear();
+    entries = 0;
+    lastEntry.clear();
+    repeats = 0;
+}
+
+uint32_t ActionJournal::intern(const std::string &text)
+{
+    int index = strings.find(text);
+    if (index < 0)
+    {
+        index = static_cast<int>(strings.size());
+        strings.add(text, text);
+    }
+    return static_cast<uint32_t>(index);
+}
+
+// Write down how many times the last entry repeated
+void ActionJournal::writeRepeats()
+{
+    if (repeats == 0)
+    {
+        return;
+    }
+    uint8_t marker[11] = {REPEAT};
+    write(marker, 1 + putVarint(marker + 1, repeats));
+    repeats = 0;
+}
+
+void ActionJournal::write(const uint8_t *bytes, size_t count)
+{
+    truncate();
+    data->tail.insert(data->tail.end(), bytes, bytes + count);
+    length += count;
+    if (data->tail.size() >= windowBytes)
+    {
+        spill(*data);
+    }
+}
+
+// Forget bytes a newer copy appended past this journal's view (after a restore)
+void ActionJournal::truncate()
+{
+    if (data->fileLength + data->tail.size() == length)
+    {
+        return;
+    }
+    if (length >= data->fileLength)
+    {
+        data->tail.resize(length - data->fileLength);
+        return;
+    }
+    // The file keeps its bytes past fileLength; they are never read and the next spill overwrites them
+    data->fileLength = length;
+    data->tail.clear();
+}
+
+// Move target's in-memory entries to the end of its file. If there is no file to write to, they stay in memory.
+void ActionJournal::spill(Data &target)
+{
+    if (target.file < 0)
+    {
+        FILE *file = tmpfile(); // Deleted once closed
+        if (file == nullptr)
+        {
+            return;
+        }
+        target.file = dup(fileno(file));
+        fclose(file);
+        if (target.file < 0)
+        {
+            return;
+        }
+    }
+    size_t written = 0;
+    while (written < target.tail.size())
+    {
+        ssize_t count = pwrite(target.file, target.tail.data() + written, target.tail.size() - written, static_cast<off_t>(target.fileLength + written));
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return; // Keep everything in memory; a later spill writes it again from the same offset
+        }
+        written += static_cast<size_t>(count);
+    }
+    target.fileLength += written;
+    target.tail.clear();
+}
@@ -20,3 +20,87 @@ std::vector<std::string> Auxiliary::parseArguments(const std::string &line)
 
     return arguments;
 }
+
+/*
+Allocation-free version of parseArguments: splits [begin, end) on whitespace and stores up to
+maxArguments arguments, which point into the caller's buffer. Returns how many arguments the
+line has (possibly more than were stored).
+*/
+int Auxiliary::splitArguments(const char *begin, const char *end, ArgumentView *arguments, int maxArguments)
+{
+    // The characters istream treats as whitespace in the "C" locale
+    auto isSpace = [](char c)
+    { return c == ' ' || (c >= '\t' && c <= '\r'); };
+
+    int count = 0;
+    const char *cursor = begin;
+    while (true)
+    {
+        while (cursor < end && isSpace(*cursor))
+        {
+            ++cursor;
+        }
+        if (cursor == end)
+        {
+            return count;
+        }
+        const char *start = cursor;
+        while (cursor < end && !isSpace(*cursor))
+        {
+            ++cursor;
+        }
+        if (count < maxArguments)
+        {
+            arguments[count] = ArgumentView{start, static_cast<size_t>(cursor - start)};
+        }
+        ++count;
+    }
+}
+
+/*
+Reads an int the way stoi does (optional sign, decimal digits, anything after them ignored),
+but reports a missing number or an overflow by returning false instead of throwing.
+*/
+bool Auxiliary::parseInt(const ArgumentView &argument, int &value)
+{
+    const char *cursor = argument.begin;
+    const char *end = argument.begin + argument.length;
+    bool negative = false;
+    if (cursor < end && (*cursor == '+' || *cursor == '-'))
+    {
+        negative = *cursor == '-';
+        ++cursor;
+    }
+    if (cursor == end || *cursor < '0' || *cursor > '9')
+    {
+        return false;
+    }
+    long long magnitude = 0;
+    const long long limit = negative ? 2147483648LL : 2147483647LL;
+    for (; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor)
+    {
+        magnitude = magnitude * 10 + (*cursor - '0');
+        if (magnitude > limit)
+        {
+            return false;
+        }
+    }
+    value = static_cast<int>(negative ? -magnitude : magnitude);
+    return true;
+}
+
+bool ArgumentView::operator==(const char *word) const
+{
+    size_t wordLength = std::char_traits<char>::length(word);
+    return wordLength == length && std::char_traits<char>::compare(begin, word, length) == 0;
+}
+
+bool ArgumentView::operator!=(const char *word) const
+{
+    return !(*this == word);
+}
+
+std::string ArgumentView::str() const
+{
+    return std::string(begin, length);
+}
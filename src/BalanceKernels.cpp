@@ -0,0 +1,113 @@
+#include "BalanceKernels.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BALANCE_KERNEL_X86
+#endif
+
+namespace
+{
+    void balanceScanScalar(const FacilityColumns &columns, size_t begin, size_t end, int lifeQuality, int economy, int environment,
+                           int &bestGap, int &bestPosition)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            int a = lifeQuality + columns.lifeQuality[i];
+            int b = economy + columns.economy[i];
+            int c = environment + columns.environment[i];
+            int gap = std::max(std::max(std::abs(a - b), std::abs(b - c)), std::abs(c - a));
+            if (gap < bestGap)
+            {
+                bestGap = gap;
+                bestPosition = static_cast<int>(i);
+            }
+        }
+    }
+
+#ifdef BALANCE_KERNEL_X86
+    // Each lane keeps its own first minimum (strict <), so the overall first minimum is the
+    // smallest position among the lanes holding the smallest gap
+    void mergeLanes(const int *gaps, const int *positions, int lanes, int &bestGap, int &bestPosition)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            if (gaps[lane] < bestGap || (gaps[lane] == bestGap && positions[lane] >= 0 && positions[lane] < bestPosition))
+            {
+                bestGap = gaps[lane];
+                bestPosition = positions[lane];
+            }
+        }
+    }
+
+    __attribute__((target("sse4.1"))) void balanceScanSse41(const FacilityColumns &columns, size_t begin, size_t end, int lifeQuality, int economy,
+                                                             int environment, int &bestGap, int &bestPosition)
+    {
+        const __m128i totalA = _mm_set1_epi32(lifeQuality), totalB = _mm_set1_epi32(economy), totalC = _mm_set1_epi32(environment);
+        __m128i gaps = _mm_set1_epi32(INT_MAX), positions = _mm_set1_epi32(-1);
+        __m128i position = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(begin)), _mm_setr_epi32(0, 1, 2, 3));
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128i a = _mm_add_epi32(totalA, _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns.lifeQuality + i)));
+            __m128i b = _mm_add_epi32(totalB, _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns.economy + i)));
+            __m128i c = _mm_add_epi32(totalC, _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns.environment + i)));
+            __m128i gap = _mm_max_epi32(_mm_max_epi32(_mm_abs_epi32(_mm_sub_epi32(a, b)), _mm_abs_epi32(_mm_sub_epi32(b, c))),
+                                        _mm_abs_epi32(_mm_sub_epi32(c, a)));
+            __m128i better = _mm_cmpgt_epi32(gaps, gap);
+            gaps = _mm_blendv_epi8(gaps, gap, better);
+            positions = _mm_blendv_epi8(positions, position, better);
+            position = _mm_add_epi32(position, _mm_set1_epi32(4));
+        }
+        int laneGaps[4], lanePositions[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(laneGaps), gaps);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanePositions), positions);
+        mergeLanes(laneGaps, lanePositions, 4, bestGap, bestPosition);
+        balanceScanScalar(columns, i, end, lifeQuality, economy, environment, bestGap, bestPosition);
+    }
+
+    __attribute__((target("avx2"))) void balanceScanAvx2(const FacilityColumns &columns, size_t begin, size_t end, int lifeQuality, int economy,
+                                                         int environment, int &bestGap, int &bestPosition)
+    {
+        const __m256i totalA = _mm256_set1_epi32(lifeQuality), totalB = _mm256_set1_epi32(economy), totalC = _mm256_set1_epi32(environment);
+        __m256i gaps = _mm256_set1_epi32(INT_MAX), positions = _mm256_set1_epi32(-1);
+        __m256i position = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256i a = _mm256_add_epi32(totalA, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columns.lifeQuality + i)));
+            __m256i b = _mm256_add_epi32(totalB, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columns.economy + i)));
+            __m256i c = _mm256_add_epi32(totalC, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columns.environment + i)));
+            __m256i gap = _mm256_max_epi32(_mm256_max_epi32(_mm256_abs_epi32(_mm256_sub_epi32(a, b)), _mm256_abs_epi32(_mm256_sub_epi32(b, c))),
+                                           _mm256_abs_epi32(_mm256_sub_epi32(c, a)));
+            __m256i better = _mm256_cmpgt_epi32(gaps, gap);
+            gaps = _mm256_blendv_epi8(gaps, gap, better);
+            positions = _mm256_blendv_epi8(positions, position, better);
+            position = _mm256_add_epi32(position, _mm256_set1_epi32(8));
+        }
+        int laneGaps[8], lanePositions[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(laneGaps), gaps);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanePositions), positions);
+        mergeLanes(laneGaps, lanePositions, 8, bestGap, bestPosition);
+        balanceScanScalar(columns, i, end, lifeQuality, economy, environment, bestGap, bestPosition);
+    }
+#endif
+}
+
+std::vector<BalanceKernelEntry> supportedBalanceKernels()
+{
+    std::vector<BalanceKernelEntry> kernels = {{"scalar", balanceScanScalar}};
+#ifdef BALANCE_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        kernels.push_back(BalanceKernelEntry{"sse4.1", balanceScanSse41});
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(BalanceKernelEntry{"avx2", balanceScanAvx2});
+    }
+#endif
+    return kernels;
+}
@@ -0,0 +1,111 @@
+#include "Commands.h"
+#include "Action.h"
+#include "Settlement.h"
+#include <new>
+#include <string>
+#include <utility>
+
+namespace
+{
+    template <typename Action, typename... Args>
+    BaseAction *build(void *storage, Args &&...args)
+    {
+        static_assert(sizeof(Action) <= sizeof(ActionStorage), "ActionStorage is too small");
+        return new (storage) Action(std::forward<Args>(args)...);
+    }
+
+    // stoi of an argument, throwing what stoi throws for a bad number
+    int toInt(const ArgumentView &argument)
+    {
+        int value;
+        return Auxiliary::parseInt(argument, value) ? value : std::stoi(argument.str());
+    }
+
+    const Command commands[] = {
+        {"step", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<SimulateStep>(storage, toInt(args[1])); }},
+        {"plan", 3, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<AddPlan>(storage, args[1].str(), args[2].str()); }},
+        {"plan", 4, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             if (args[2] != "opt")
+                 return nullptr;
+             return build<AddPlan>(storage, args[1].str(), "opt " + args[3].str());
+         }},
+        {"plan", 7, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             if (args[2] != "opt")
+                 return nullptr;
+             return build<AddPlan>(storage, args[1].str(), "opt " + args[3].str() + " " + args[4].str() + " " + args[5].str() + " " + args[6].str());
+         }},
+        {"settlement", 3, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<AddSettlement>(storage, args[1].str(), static_cast<SettlementType>(toInt(args[2]))); }},
+        {"facility", 7, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             FacilityCategory category = static_cast<FacilityCategory>(toInt(args[2]));
+             int price = toInt(args[3]);
+             int lifeQualityScore = toInt(args[4]);
+             int economyScore = toInt(args[5]);
+             int environmentScore = toInt(args[6]);
+             return build<AddFacility>(storage, args[1].str(), category, price, lifeQualityScore, economyScore, environmentScore);
+         }},
+        {"planStatus", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<PrintPlanStatus>(storage, toInt(args[1])); }},
+        {"changePolicy", 3, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<ChangePlanPolicy>(storage, toInt(args[1]), args[2].str()); }},
+        {"changePolicy", 4, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             if (args[2] != "opt")
+                 return nullptr;
+             int planID = toInt(args[1]);
+             return build<ChangePlanPolicy>(storage, planID, "opt " + args[3].str());
+         }},
+        {"changePolicy", 7, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             if (args[2] != "opt")
+                 return nullptr;
+             int planID = toInt(args[1]);
+             return build<ChangePlanPolicy>(storage, planID, "opt " + args[3].str() + " " + args[4].str() + " " + args[5].str() + " " + args[6].str());
+         }},
+        {"compare", 3, [](const ArgumentView *args, void *storage) -> BaseAction *
+         {
+             int planID = toInt(args[1]);
+             int steps = toInt(args[2]);
+             return build<ComparePolicies>(storage, planID, steps);
+         }},
+        {"autotune", 3, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<AutotunePolicies>(storage, toInt(args[1]), args[2].str()); }},
+        {"log", 1, [](const ArgumentView *, void *storage) -> BaseAction *
+         { return build<PrintActionsLog>(storage); }},
+        {"backup", 1, [](const ArgumentView *, void *storage) -> BaseAction *
+         { return build<BackupSimulation>(storage); }},
+        {"restore", 1, [](const ArgumentView *, void *storage) -> BaseAction *
+         { return build<RestoreSimulation>(storage); },
+         true},
+        {"save", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<SaveSimulation>(storage, args[1].str()); }},
+        {"load", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<LoadSimulation>(storage, args[1].str()); },
+         true},
+        {"rewind", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<RewindSimulation>(storage, toInt(args[1])); },
+         true},
+        {"source", 2, [](const ArgumentView *args, void *storage) -> BaseAction *
+         { return build<SourceCommands>(storage, args[1].str()); }},
+        {"close", 1, [](const ArgumentView *, void *storage) -> BaseAction *
+         { return build<Close>(storage); }},
+    };
+}
+
+// The command a split line names, or nullptr
+const Command *findCommand(const ArgumentView *args, int argCount)
+{
+    for (const Command &command : commands)
+    {
+        if (command.argCount == argCount && args[0] == command.verb)
+        {
+            return &command;
+        }
+    }
+    return nullptr;
+}
@@ -1,21 +1,64 @@
 // Facility.cpp
 #include "Facility.h"
 
-Facility::Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score)
-    : FacilityType(name, category, price, lifeQuality_score, economy_score, environment_score),
-      settlementName(settlementName),
+Facility::Facility(const FacilityCatalog &facilityOptions, int typeIndex, const Settlement &settlement)
+    : facilityOptions(&facilityOptions),
+      typeIndex(typeIndex),
+      settlement(&settlement),
       status(FacilityStatus::UNDER_CONSTRUCTIONS),
-      timeLeft(price) {}
+      timeLeft(facilityOptions[typeIndex].getCost()) {}
 
-Facility::Facility(const FacilityType &type, const string &settlementName)
-    : FacilityType(type),
-      settlementName(settlementName),
-      status(FacilityStatus::UNDER_CONSTRUCTIONS),
-      timeLeft(type.getCost()) {}
+// A facility that is already partly built
+Facility::Facility(const FacilityCatalog &facilityOptions, int typeIndex, const Settlement &settlement, int timeLeft)
+    : facilityOptions(&facilityOptions),
+      typeIndex(typeIndex),
+      settlement(&settlement),
+      status(timeLeft != 0 ? FacilityStatus::UNDER_CONSTRUCTIONS : FacilityStatus::OPERATIONAL),
+      timeLeft(timeLeft) {}
+
+const FacilityType &Facility::getType() const
+{
+    return (*facilityOptions)[typeIndex];
+}
+
+const string &Facility::getName() const
+{
+    return getType().getName();
+}
+
+int Facility::getCost() const
+{
+    return getType().getCost();
+}
+
+int Facility::getLifeQualityScore() const
+{
+    return getType().getLifeQualityScore();
+}
+
+int Facility::getEnvironmentScore() const
+{
+    return getType().getEnvironmentScore();
+}
+
+int Facility::getEconomyScore() const
+{
+    return getType().getEconomyScore();
+}
+
+FacilityCategory Facility::getCategory() const
+{
+    return getType().getCategory();
+}
 
 const string &Facility::getSettlementName() const
 {
-    return settlementName;
+    return settlement->getName();
+}
+
+int Facility::getTypeIndex() const
+{
+    return typeIndex;
 }
 
 const int Facility::getTimeLeft() const
@@ -24,10 +67,16 @@ const int Facility::getTimeLeft() const
 }
 
 FacilityStatus Facility::step()
+{
+    return step(1);
+}
+
+// Apply several ticks of construction at once. Like step(), a negative time left (a negative price) never counts down.
+FacilityStatus Facility::step(int ticks)
 {
     if (timeLeft > 0)
     {
-        --timeLeft;
+        timeLeft = timeLeft > ticks ? timeLeft - ticks : 0;
     }
     if (timeLeft == 0)
     {
@@ -54,6 +103,5 @@ const FacilityStatus &Facility::getStatus() const
 const string Facility::toString() const
 {
     string statusStr = (status == FacilityStatus::UNDER_CONSTRUCTIONS) ? "UNDER_CONSTRUCTIONS" : "OPERATIONAL";
-    return "Facility: " + getName() + ", Settlement: " + settlementName + ", Status: " + statusStr + ", Time Left: " + std::to_string(timeLeft);
-    ;
+    return "Facility: " + getName() + ", Settlement: " + getSettlementName() + ", Status: " + statusStr + ", Time Left: " + std::to_string(timeLeft);
 }
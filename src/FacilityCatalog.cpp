@@ -0,0 +1,229 @@
+#include "Facility.h"
+#include "BalanceKernels.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+FacilityCatalog::FacilityCatalog()
+    : types(), categories(), lifeQualityColumn(), economyColumn(), environmentColumn(), priceColumn(), categoryColumn(), balanceTree(), balanceTreeMutex(), balanceTreeVersion(0), version(0) {}
+
+size_t FacilityCatalog::size() const
+{
+    return types.size();
+}
+
+bool FacilityCatalog::empty() const
+{
+    return types.empty();
+}
+
+const FacilityType &FacilityCatalog::operator[](size_t index) const
+{
+    return types[index];
+}
+
+const FacilityType *FacilityCatalog::data() const
+{
+    return types.data();
+}
+
+FacilityCatalog::const_iterator FacilityCatalog::begin() const
+{
+    return types.begin();
+}
+
+FacilityCatalog::const_iterator FacilityCatalog::end() const
+{
+    return types.end();
+}
+
+const vector<int> &FacilityCatalog::ofCategory(FacilityCategory category) const
+{
+    return categories[static_cast<int>(category)];
+}
+
+FacilityColumns FacilityCatalog::columns() const
+{
+    return FacilityColumns{lifeQualityColumn.data(), economyColumn.data(), environmentColumn.data(), priceColumn.data(), categoryColumn.data(), types.size()};
+}
+
+unsigned long FacilityCatalog::getVersion() const
+{
+    return version;
+}
+
+void FacilityCatalog::push_back(const FacilityType &type)
+{
+    categories[static_cast<int>(type.getCategory())].push_back(static_cast<int>(types.size()));
+    lifeQualityColumn.push_back(type.getLifeQualityScore());
+    economyColumn.push_back(type.getEconomyScore());
+    environmentColumn.push_back(type.getEnvironmentScore());
+    priceColumn.push_back(type.getCost());
+    categoryColumn.push_back(static_cast<int>(type.getCategory()));
+    types.push_back(type);
+    ++version;
+}
+
+// Types are only ever removed from the end, so the last position of its category is this one
+void FacilityCatalog::pop_back()
+{
+    categories[static_cast<int>(types.back().getCategory())].pop_back();
+    lifeQualityColumn.pop_back();
+    economyColumn.pop_back();
+    environmentColumn.pop_back();
+    priceColumn.pop_back();
+    categoryColumn.pop_back();
+    types.pop_back();
+    ++version;
+}
+
+namespace
+{
+    // Below this many types a vectorized scan beats searching (and rebuilding) the k-d tree
+    const size_t BALANCE_SCAN_LIMIT = 128;
+}
+
+// Vectorized scan of the whole catalog for the most balanced type
+int FacilityCatalog::scanMostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const
+{
+    static const BalanceKernel kernel = supportedBalanceKernels().back().scan;
+    int bestGap = INT_MAX;
+    int bestPosition = -1;
+    kernel(columns(), 0, types.size(), lifeQualityScore, economyScore, environmentScore, bestGap, bestPosition);
+    return bestPosition;
+}
+
+/*
+Position of the type that, added to the given totals, leaves the smallest gap between the highest
+and lowest total; the first in catalog order on ties. -1 if the catalog is empty.
+
+With x = (lifeQualityScore - economyScore) + (l - e) and y = (economyScore - environmentScore) + (e - v)
+for a type scoring (l, e, v), the gap is max(|x|, |y|, |x + y|). So this is a nearest-point search
+around (targetX, targetY) under that distance, over a k-d tree of the types' (l - e, e - v).
+Small catalogs are scanned instead.
+*/
+int FacilityCatalog::mostBalanced(int lifeQualityScore, int economyScore, int environmentScore) const
+{
+    if (types.size() <= BALANCE_SCAN_LIMIT)
+    {
+        return scanMostBalanced(lifeQualityScore, economyScore, environmentScore);
+    }
+    if (balanceTreeVersion.load(std::memory_order_acquire) != version)
+    {
+        std::lock_guard<std::mutex> lock(balanceTreeMutex);
+        if (balanceTreeVersion.load(std::memory_order_relaxed) != version)
+        {
+            buildBalanceTree();
+            balanceTreeVersion.store(version, std::memory_order_release);
+        }
+    }
+
+    long long bestGap = LLONG_MAX;
+    int bestPosition = -1;
+    searchBalanceTree(0, balanceTree.size(), true, (long long)economyScore - lifeQualityScore, (long long)environmentScore - economyScore,
+                      bestGap, bestPosition);
+    return bestPosition;
+}
+
+// Types with the same differences always leave the same gap, so only the first of them is kept
+void FacilityCatalog::buildBalanceTree() const
+{
+    balanceTree.clear();
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        long long x = (long long)lifeQualityColumn[i] - economyColumn[i];
+        long long y = (long long)economyColumn[i] - environmentColumn[i];
+        balanceTree.push_back(BalanceNode{x, y, static_cast<int>(i), static_cast<int>(i), x, x, y, y});
+    }
+    std::sort(balanceTree.begin(), balanceTree.end(), [](const BalanceNode &a, const BalanceNode &b)
+              { return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.position < b.position; });
+    balanceTree.erase(std::unique(balanceTree.begin(), balanceTree.end(), [](const BalanceNode &a, const BalanceNode &b)
+                                  { return a.x == b.x && a.y == b.y; }),
+                      balanceTree.end());
+    buildBalanceTree(0, balanceTree.size(), true);
+}
+
+void FacilityCatalog::buildBalanceTree(size_t begin, size_t end, bool splitOnX) const
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    std::nth_element(balanceTree.begin() + begin, balanceTree.begin() + middle, balanceTree.begin() + end,
+                     [splitOnX](const BalanceNode &a, const BalanceNode &b)
+                     { return splitOnX ? a.x < b.x : a.y < b.y; });
+    buildBalanceTree(begin, middle, !splitOnX);
+    buildBalanceTree(middle + 1, end, !splitOnX);
+
+    BalanceNode &node = balanceTree[middle];
+    node.minX = node.maxX = node.x;
+    node.minY = node.maxY = node.y;
+    node.minPosition = node.position;
+    auto include = [&node](const BalanceNode &child)
+    {
+        node.minX = std::min(node.minX, child.minX);
+        node.maxX = std::max(node.maxX, child.maxX);
+        node.minY = std::min(node.minY, child.minY);
+        node.maxY = std::max(node.maxY, child.maxY);
+        node.minPosition = std::min(node.minPosition, child.minPosition);
+    };
+    if (begin < middle)
+    {
+        include(balanceTree[begin + (middle - begin) / 2]);
+    }
+    if (middle + 1 < end)
+    {
+        include(balanceTree[middle + 1 + (end - middle - 1) / 2]);
+    }
+}
+
+namespace
+{
+    // Distance from 0 to [low, high]
+    long long distanceToRange(long long low, long long high)
+    {
+        return low > 0 ? low : high < 0 ? -high : 0;
+    }
+}
+
+void FacilityCatalog::searchBalanceTree(size_t begin, size_t end, bool splitOnX, long long targetX, long long targetY, long long &bestGap, int &bestPosition) const
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    const BalanceNode &node = balanceTree[middle];
+
+    // Each of |x|, |y| and |x + y| is at least its distance from 0 over the subtree's box. A subtree
+    // that cannot beat the best gap, or only tie it with later types, is skipped.
+    long long lowX = node.minX - targetX, highX = node.maxX - targetX;
+    long long lowY = node.minY - targetY, highY = node.maxY - targetY;
+    long long bound = std::max(std::max(distanceToRange(lowX, highX), distanceToRange(lowY, highY)), distanceToRange(lowX + lowY, highX + highY));
+    if (bound > bestGap || (bound == bestGap && node.minPosition > bestPosition))
+    {
+        return;
+    }
+
+    long long x = node.x - targetX, y = node.y - targetY;
+    long long gap = std::max(std::max(std::llabs(x), std::llabs(y)), std::llabs(x + y));
+    if (gap < bestGap || (gap == bestGap && node.position < bestPosition))
+    {
+        bestGap = gap;
+        bestPosition = node.position;
+    }
+
+    // The side of the split the target is on first, so the bound prunes more of the other
+    bool targetFirst = splitOnX ? x >= 0 : y >= 0;
+    if (targetFirst)
+    {
+        searchBalanceTree(begin, middle, !splitOnX, targetX, targetY, bestGap, bestPosition);
+        searchBalanceTree(middle + 1, end, !splitOnX, targetX, targetY, bestGap, bestPosition);
+    }
+    else
+    {
+        searchBalanceTree(middle + 1, end, !splitOnX, targetX, targetY, bestGap, bestPosition);
+        searchBalanceTree(begin, middle, !splitOnX, targetX, targetY, bestGap, bestPosition);
+    }
+}
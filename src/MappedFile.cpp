@@ -0,0 +1,61 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path) : opened(false), mapping(nullptr), length(0), buffer()
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            mapping = mapped;
+            length = static_cast<size_t>(info.st_size);
+            madvise(mapping, length, MADV_SEQUENTIAL);
+        }
+    }
+    opened = mapping != nullptr;
+    if (!opened)
+    {
+        char chunk[1 << 16];
+        ssize_t count;
+        while ((count = read(fd, chunk, sizeof(chunk))) > 0)
+        {
+            buffer.insert(buffer.end(), chunk, chunk + count);
+        }
+        length = buffer.size();
+        opened = count == 0;
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapping)
+    {
+        munmap(mapping, length);
+    }
+}
+
+bool MappedFile::isOpen() const
+{
+    return opened;
+}
+
+const char *MappedFile::data() const
+{
+    return mapping ? static_cast<const char *>(mapping) : buffer.data();
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
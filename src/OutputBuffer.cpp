@@ -0,0 +1,42 @@
+#include "OutputBuffer.h"
+
+OutputBuffer::OutputBuffer(std::ostream &stream, size_t capacity) : stream(stream), target(stream.rdbuf()), buffer(capacity > 0 ? capacity : 1)
+{
+    setp(buffer.data(), buffer.data() + buffer.size());
+    stream.rdbuf(this);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    drain();
+    stream.rdbuf(target);
+}
+
+void OutputBuffer::drain()
+{
+    std::streamsize pending = pptr() - pbase();
+    if (pending > 0)
+    {
+        target->sputn(pbase(), pending);
+    }
+    target->pubsync();
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+// The buffer is full: write it out and keep c
+OutputBuffer::int_type OutputBuffer::overflow(int_type c)
+{
+    drain();
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+// Flushes are left to drain()
+int OutputBuffer::sync()
+{
+    return 0;
+}
@@ -2,33 +2,126 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <climits>
+#include <map>
+#include <utility>
 
 using namespace std;
 
+namespace
+{
+    // A metropolis has the most construction slots of the known settlement types (see getConstructionLimit)
+    const int MAX_CONSTRUCTION_LIMIT = static_cast<int>(SettlementType::METROPOLIS) + 1;
+
+    // Everything that decides a round-robin plan's future: the policy cursor and the
+    // facilities under construction (in order, with their timers)
+    struct CycleState
+    {
+        int cursor;
+        int slotCount;
+        pair<int, int> slots[MAX_CONSTRUCTION_LIMIT]; // (typeIndex, timeLeft)
+
+        bool operator<(const CycleState &other) const
+        {
+            if (cursor != other.cursor)
+            {
+                return cursor < other.cursor;
+            }
+            return lexicographical_compare(slots, slots + slotCount, other.slots, other.slots + other.slotCount);
+        }
+    };
+
+    // Where the plan was when a CycleState was first seen
+    struct CyclePoint
+    {
+        int stepsLeft;
+        size_t completedCount;
+        int lifeQuality, economy, environment;
+    };
+}
+
+OperationalFacilities::OperationalFacilities(const vector<FacilityCount> &counts, const FacilityCatalog &facilityOptions)
+    : counts(counts), facilityOptions(facilityOptions) {}
+
+OperationalFacilities::Iterator OperationalFacilities::begin() const
+{
+    return Iterator(*this, 0);
+}
+
+OperationalFacilities::Iterator OperationalFacilities::end() const
+{
+    return Iterator(*this, counts.size());
+}
+
+size_t OperationalFacilities::size() const
+{
+    size_t total = 0;
+    for (const FacilityCount &entry : counts)
+    {
+        total += entry.count;
+    }
+    return total;
+}
+
+OperationalFacilities::Iterator::Iterator(const OperationalFacilities &view, size_t entry)
+    : view(&view), entry(entry), repeat(0) {}
+
+const FacilityType &OperationalFacilities::Iterator::operator*() const
+{
+    return view->facilityOptions[view->counts[entry].typeIndex];
+}
+
+OperationalFacilities::Iterator &OperationalFacilities::Iterator::operator++()
+{
+    if (++repeat >= view->counts[entry].count)
+    {
+        ++entry;
+        repeat = 0;
+    }
+    return *this;
+}
+
+bool OperationalFacilities::Iterator::operator!=(const Iterator &other) const
+{
+    return entry != other.entry || repeat != other.repeat;
+}
+
 Plan::Plan(const int planId,
            const Settlement &settlement,
            SelectionPolicy *selectionPolicy,
-           const std::vector<FacilityType> &facilityOptions,
+           PlanStatus status,
+           const FacilityCatalog &facilityOptions,
            int life_quality_score,
            int economy_score,
            int environment_score,
-           std::vector<Facility *> facilities,
-           std::vector<Facility *> underConstruction)
+           std::vector<FacilityCount> facilities,
+           std::vector<Facility> underConstruction)
     : Plan(planId, settlement, selectionPolicy, facilityOptions)
 {
+    this->status = status;
     this->life_quality_score = life_quality_score;
     this->economy_score = economy_score;
     this->environment_score = environment_score;
     this->facilities = std::move(facilities);
     this->underConstruction = std::move(underConstruction);
+    for (size_t i = 0; i < this->facilities.size(); ++i)
+    {
+        int typeIndex = this->facilities[i].typeIndex;
+        if (typeIndex >= (int)facilitySlots.size())
+        {
+            facilitySlots.resize(typeIndex + 1, -1);
+        }
+        facilitySlots[typeIndex] = static_cast<int>(i);
+    }
 }
 
-Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions)
+Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const FacilityCatalog &facilityOptions)
     : plan_id(planId),
       settlement(settlement),
       selectionPolicy(selectionPolicy),
       status(PlanStatus::AVALIABLE),
       facilities(),
+      facilitySlots(),
       underConstruction(),
       facilityOptions(facilityOptions),
       life_quality_score(0),
@@ -37,16 +130,6 @@ Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *sele
 
 Plan::~Plan()
 {
-    for (auto f : facilities)
-    {
-        delete f;
-    }
-    facilities.clear();
-    for (auto f : underConstruction)
-    {
-        delete f;
-    }
-    underConstruction.clear();
     if (selectionPolicy)
     {
         delete selectionPolicy;
@@ -58,22 +141,14 @@ Plan::Plan(const Plan &other)
       settlement(other.settlement),
       selectionPolicy(other.selectionPolicy->clone()), // Clone policy
       status(other.status),
-      facilities(),
-      underConstruction(),
+      facilities(other.facilities),
+      facilitySlots(other.facilitySlots),
+      underConstruction(other.underConstruction),
       facilityOptions(other.facilityOptions),
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
       environment_score(other.environment_score)
 {
-    for (const auto facility : other.facilities)
-    {
-        facilities.push_back(new Facility(*facility));
-    }
-
-    for (const auto facility : other.underConstruction)
-    {
-        underConstruction.push_back(new Facility(*facility));
-    }
 }
 
 Plan &Plan::operator=(const Plan &other)
@@ -84,40 +159,24 @@ Plan &Plan::operator=(const Plan &other)
     }
 
     // Clean up existing resources
-    for (auto f : facilities)
-    {
-        delete f;
-    }
-    facilities.clear();
-
-    for (auto f : underConstruction)
-    {
-        delete f;
-    }
-    underConstruction.clear();
-
     delete selectionPolicy;
     selectionPolicy = nullptr;
 
     plan_id = other.plan_id;
     // settlement = other.settlement; // Not possible if it's a reference and must remain from constructor
-    // settlement is a reference, so we handle appropriately with cloneDeep function when relevant
+    // so settlement stays the one this plan was built with. The copy-on-write copy of a shared plan (Simulation::ownPlan)
+    // uses the copy constructor instead, which takes both; either way facilitySlots is copied along with facilities
     life_quality_score = other.life_quality_score;
     economy_score = other.economy_score;
     environment_score = other.environment_score;
     selectionPolicy = other.selectionPolicy ? other.selectionPolicy->clone() : nullptr;
 
-    // Deep copy facilities
-    for (auto f : other.facilities)
-    {
-        facilities.push_back(f->clone());
-    }
+    // Operational facilities are plain counts
+    facilities = other.facilities;
+    facilitySlots = other.facilitySlots;
 
-    // Deep copy under construction
-    for (auto f : other.underConstruction)
-    {
-        underConstruction.push_back(f->clone());
-    }
+    // Facilities under construction are plain values
+    underConstruction = other.underConstruction;
 
     return *this;
 }
@@ -128,6 +187,7 @@ Plan::Plan(Plan &&other) noexcept
       selectionPolicy(other.selectionPolicy),
       status(other.status),
       facilities(std::move(other.facilities)),
+      facilitySlots(std::move(other.facilitySlots)),
       underConstruction(std::move(other.underConstruction)),
       facilityOptions(std::move(other.facilityOptions)),
       life_quality_score(other.life_quality_score),
@@ -137,58 +197,6 @@ Plan::Plan(Plan &&other) noexcept
     other.selectionPolicy = nullptr; // Nullify moved-from pointer
 }
 
-Plan Plan::cloneDeep(const std::vector<Settlement *> &settlements,
-                     const std::vector<FacilityType> &facilitiesOptions) const
-{
-    // Find corresponding Settlement by name
-    Settlement *newSettlement = nullptr;
-    for (Settlement *currentSettlement : settlements)
-    {
-        if (currentSettlement->getName() == settlement.getName())
-        {
-            newSettlement = currentSettlement;
-            break;
-        }
-    }
-
-    // Ensure newSettlement is valid
-    if (!newSettlement)
-    {
-        throw std::runtime_error("Settlement not found for cloning Plan");
-    }
-
-    // Deep copy facilities
-    std::vector<Facility *> newFacilities;
-    newFacilities.reserve(facilities.size());
-    for (Facility *facility : facilities)
-    {
-        newFacilities.push_back(facility->clone());
-    }
-
-    // Deep copy under-construction facilities
-    std::vector<Facility *> newUnderConstruction;
-    newUnderConstruction.reserve(underConstruction.size());
-    for (Facility *facility : underConstruction)
-    {
-        newUnderConstruction.push_back(facility->clone());
-    }
-
-    // Clone selectionPolicy if exists
-    SelectionPolicy *newPolicy = selectionPolicy ? selectionPolicy->clone() : nullptr;
-
-    // Create and return the new Plan object
-    return Plan(
-        plan_id,
-        *newSettlement,
-        newPolicy,
-        facilitiesOptions,
-        life_quality_score,
-        economy_score,
-        environment_score,
-        std::move(newFacilities),
-        std::move(newUnderConstruction));
-}
-
 // Getters for scores
 const int Plan::getlifeQualityScore() const
 {
@@ -210,6 +218,11 @@ const int Plan::getPlanId() const
     return plan_id;
 }
 
+const Settlement &Plan::getSettlement() const
+{
+    return settlement;
+}
+
 PlanStatus Plan::getPlanStatus()
 {
     if ((int)underConstruction.size() < getConstructionLimit())
@@ -223,12 +236,17 @@ PlanStatus Plan::getPlanStatus()
     return status;
 }
 
-const string Plan::getSelectionPolicyType()
+PlanStatus Plan::getStatus() const
+{
+    return status;
+}
+
+const string Plan::getSelectionPolicyType() const
 {
     return this->selectionPolicy->getPolicyType();
 }
 
-const int Plan::getConstructionLimit()
+const int Plan::getConstructionLimit() const
 {
     return static_cast<int>(settlement.getType()) + 1;
 }
@@ -243,17 +261,71 @@ void Plan::setSelectionPolicy(SelectionPolicy *newSelectionPolicy)
 // Simulate one step
 void Plan::step()
 {
-    while (getPlanStatus() == PlanStatus::AVALIABLE)
+    step(nullptr);
+}
+
+// Fill every free slot with one call to the concrete policy (the classes are final, so it is not virtual),
+// in storage reserved for all of them. The picks go on the stack unless the settlement type is past
+// METROPOLIS and has more slots than that.
+template <typename Policy>
+void Plan::fillSlots(Policy &policy)
+{
+    int freeSlots = getConstructionLimit() - (int)underConstruction.size();
+    int stackPositions[MAX_CONSTRUCTION_LIMIT];
+    vector<int> heapPositions;
+    int *positions = stackPositions;
+    if (freeSlots > MAX_CONSTRUCTION_LIMIT)
+    {
+        heapPositions.resize(freeSlots);
+        positions = heapPositions.data();
+    }
+    policy.selectFacilities(facilityOptions, freeSlots, positions);
+    underConstruction.reserve(getConstructionLimit());
+    for (int i = 0; i < freeSlots; ++i)
     {
-        addFacility(new Facility(selectionPolicy->selectFacility(facilityOptions), settlement.getName()));
+        underConstruction.push_back(Facility(facilityOptions, positions[i], settlement));
+    }
+}
+
+// Simulate one step, appending the type of every facility that became operational to completedTypes
+void Plan::step(vector<int> *completedTypes)
+{
+    if ((int)underConstruction.size() < getConstructionLimit())
+    {
+        switch (selectionPolicy->getKind())
+        {
+        case PolicyKind::NAIVE:
+            fillSlots(static_cast<NaiveSelection &>(*selectionPolicy));
+            break;
+        case PolicyKind::BALANCED:
+            fillSlots(static_cast<BalancedSelection &>(*selectionPolicy));
+            break;
+        case PolicyKind::ECONOMY:
+            fillSlots(static_cast<EconomySelection &>(*selectionPolicy));
+            break;
+        case PolicyKind::SUSTAINABILITY:
+            fillSlots(static_cast<SustainabilitySelection &>(*selectionPolicy));
+            break;
+        case PolicyKind::LOOK_AHEAD:
+            fillSlots(static_cast<LookAheadSelection &>(*selectionPolicy));
+            break;
+        }
     }
 
     for (auto facility = underConstruction.begin(); facility != underConstruction.end();)
     {
-        FacilityStatus status = (*facility)->step();
+        FacilityStatus status = facility->step();
         if (status == FacilityStatus::OPERATIONAL)
         {
-            facilities.push_back(*facility);
+            // Scores only change when a facility becomes operational
+            life_quality_score += facility->getLifeQualityScore();
+            economy_score += facility->getEconomyScore();
+            environment_score += facility->getEnvironmentScore();
+            addOperational(facility->getTypeIndex(), 1);
+            if (completedTypes)
+            {
+                completedTypes->push_back(facility->getTypeIndex());
+            }
             facility = underConstruction.erase(facility); // Remove from under-construction
         }
         else
@@ -262,14 +334,6 @@ void Plan::step()
         }
     }
 
-    // Update scores
-    life_quality_score = economy_score = environment_score = 0;
-    for (Facility *facility : facilities)
-    {
-        life_quality_score += facility->getLifeQualityScore();
-        economy_score += facility->getEconomyScore();
-        environment_score += facility->getEnvironmentScore();
-    }
     // Set status
     if ((int)underConstruction.size() < getConstructionLimit())
     {
@@ -281,34 +345,120 @@ void Plan::step()
     }
 }
 
+// Simulate several steps, jumping over the ticks where nothing but the construction timers change.
+// Round-robin policies make the build schedule periodic, so once the plan returns to a state it
+// was already in, whole periods are applied at once.
+void Plan::step(int numOfSteps)
+{
+    map<CycleState, CyclePoint> seen;
+    vector<int> completed; // Types finished during this call, in order
+    // A settlement type past METROPOLIS has more slots than a CycleState holds; such a plan is not fast-forwarded
+    bool detectCycle = numOfSteps > 1 && selectionPolicy->getCursor() >= 0 && getConstructionLimit() <= MAX_CONSTRUCTION_LIMIT;
+    while (numOfSteps > 0)
+    {
+        int idle = std::min(idleSteps(), numOfSteps);
+        if (idle > 0)
+        {
+            for (Facility &facility : underConstruction)
+            {
+                facility.step(idle);
+            }
+            numOfSteps -= idle;
+            continue;
+        }
+        step(detectCycle ? &completed : nullptr);
+        --numOfSteps;
+
+        if (!detectCycle || numOfSteps == 0)
+        {
+            continue;
+        }
+        CycleState state{selectionPolicy->getCursor(), 0, {}};
+        for (const Facility &facility : underConstruction)
+        {
+            state.slots[state.slotCount++] = make_pair(facility.getTypeIndex(), facility.getTimeLeft());
+        }
+        auto found = seen.find(state);
+        if (found == seen.end())
+        {
+            seen.insert(make_pair(state, CyclePoint{numOfSteps, completed.size(), life_quality_score, economy_score, environment_score}));
+            continue;
+        }
+
+        const CyclePoint &start = found->second;
+        int period = start.stepsLeft - numOfSteps;
+        int repeats = numOfSteps / period;
+        for (size_t i = start.completedCount; i < completed.size(); ++i)
+        {
+            addOperational(completed[i], repeats);
+        }
+        life_quality_score += repeats * (life_quality_score - start.lifeQuality);
+        economy_score += repeats * (economy_score - start.economy);
+        environment_score += repeats * (environment_score - start.environment);
+        numOfSteps -= repeats * period;
+        detectCycle = false; // Fewer than one period is left
+    }
+}
+
+// Count operational facilities of one type
+void Plan::addOperational(int typeIndex, int count)
+{
+    if (typeIndex >= (int)facilitySlots.size())
+    {
+        facilitySlots.resize(typeIndex + 1, -1);
+    }
+    if (facilitySlots[typeIndex] < 0)
+    {
+        facilitySlots[typeIndex] = static_cast<int>(facilities.size());
+        facilities.push_back(FacilityCount{typeIndex, 0});
+    }
+    facilities[facilitySlots[typeIndex]].count += count;
+}
+
+// Number of upcoming steps that would neither start nor finish a facility
+int Plan::idleSteps() const
+{
+    if (underConstruction.empty() || (int)underConstruction.size() < getConstructionLimit())
+    {
+        return 0; // A free slot gets filled on the next step
+    }
+    int nextCompletion = INT_MAX; // Stays so when every facility has a negative time left and never finishes
+    for (const Facility &facility : underConstruction)
+    {
+        if (facility.getTimeLeft() >= 0)
+        {
+            nextCompletion = std::min(nextCompletion, facility.getTimeLeft());
+        }
+    }
+    return nextCompletion > 0 ? nextCompletion - 1 : 0;
+}
+
 // Print plan status
-void Plan::printStatus()
+void Plan::printStatus() const
 {
     std::cout << "PlanID: " << plan_id << std::endl;
     std::cout << "SettlementName: " << settlement.getName() << std::endl;
     std::cout << "PlanStatus: " << (status == PlanStatus::BUSY ? "BUSY" : "AVAILABLE") << std::endl;
     std::cout << "SelectionPolicy: " << selectionPolicy->toString() << std::endl;
+    if (selectionPolicy->getKind() == PolicyKind::LOOK_AHEAD)
+    {
+        std::cout << "PickTime: " << static_cast<const LookAheadSelection &>(*selectionPolicy).getPickTimes() << std::endl;
+    }
     std::cout << "LifeQualityScore: " << life_quality_score << std::endl;
     std::cout << "EconomyScore: " << economy_score << std::endl;
     std::cout << "EnvironmentScore: " << environment_score << std::endl;
-    // Using range-based for loop to iterate over facilities vector
-    for (const auto &facility : facilities)
+    // Operational facilities are stored per type, listed in order of first completion
+    for (const FacilityType &facility : getFacilities())
     {
-        if (facility != nullptr)
-        {
-            std::cout << "FacilityName: " << facility->getName() << std::endl;
-            std::cout << "FacilityStatus: OPERATIONAL" << std::endl;
-        }
+        std::cout << "FacilityName: " << facility.getName() << std::endl;
+        std::cout << "FacilityStatus: OPERATIONAL" << std::endl;
     }
 
     // Using range-based for loop to iterate over underConstruction vector
     for (const auto &facility : underConstruction)
     {
-        if (facility != nullptr)
-        {
-            std::cout << "FacilityName: " << facility->getName() << std::endl;
-            std::cout << "FacilityStatus: UNDER_CONSTRUCTION" << std::endl;
-        }
+        std::cout << "FacilityName: " << facility.getName() << std::endl;
+        std::cout << "FacilityStatus: UNDER_CONSTRUCTION" << std::endl;
     }
 }
 
@@ -321,14 +471,63 @@ void Plan::printShortStatus()
     std::cout << "EnvironmentScore: " << environment_score << std::endl;
 }
 
-// Get facilities
-const vector<Facility *> &Plan::getFacilities() const
+// Get operational facilities
+OperationalFacilities Plan::getFacilities() const
+{
+    return OperationalFacilities(facilities, facilityOptions);
+}
+
+const vector<FacilityCount> &Plan::getFacilityCounts() const
 {
     return facilities;
 }
 
+const vector<Facility> &Plan::getUnderConstruction() const
+{
+    return underConstruction;
+}
+
+const SelectionPolicy &Plan::getSelectionPolicy() const
+{
+    return *selectionPolicy;
+}
+
+std::shared_ptr<Plan> Plan::fork(SelectionPolicy *policy) const
+{
+    return std::make_shared<Plan>(plan_id, settlement, policy, status, facilityOptions, life_quality_score, economy_score, environment_score,
+                                  vector<FacilityCount>(), underConstruction);
+}
+
+vector<SelectionPolicy *> Plan::policyCandidates(int horizon, int &ownIndex) const
+{
+    const string names[] = {"nve", "bal", "eco", "env", "opt " + to_string(horizon)};
+    vector<SelectionPolicy *> policies;
+    ownIndex = -1;
+    for (const string &name : names)
+    {
+        PolicyKind kind;
+        LookAheadSettings settings;
+        SelectionPolicy::kindOf(name, kind, settings);
+        if (kind == selectionPolicy->getKind() && (kind != PolicyKind::LOOK_AHEAD || selectionPolicy->toString() == name))
+        {
+            ownIndex = static_cast<int>(policies.size());
+            policies.push_back(selectionPolicy->clone());
+        }
+        else
+        {
+            policies.push_back(SelectionPolicy::create(kind, life_quality_score, economy_score, environment_score, settings));
+        }
+    }
+    if (ownIndex < 0)
+    {
+        ownIndex = static_cast<int>(policies.size());
+        policies.push_back(selectionPolicy->clone());
+    }
+    return policies;
+}
+
 // Add a facility to under-construction
-void Plan::addFacility(Facility *facility)
+void Plan::addFacility(const Facility &facility)
 {
     if ((int)underConstruction.size() < getConstructionLimit())
     {
@@ -1,36 +1,22 @@
 #include "SelectionPolicy.h"
-#include <limits>
 #include <stdexcept>
 #include <iostream>
 
 using namespace std;
 
 BalancedSelection::BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore)
-    : LifeQualityScore(LifeQualityScore), EconomyScore(EconomyScore), EnvironmentScore(EnvironmentScore) {}
+    : SelectionPolicy(PolicyKind::BALANCED), LifeQualityScore(LifeQualityScore), EconomyScore(EconomyScore), EnvironmentScore(EnvironmentScore) {}
 
-const FacilityType &BalancedSelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+const FacilityType &BalancedSelection::selectFacility(const FacilityCatalog &facilitiesOptions)
 {
     if (facilitiesOptions.empty())
     {
         cout << "No available facilities to select." << endl;
     }
 
-    int minDifference = numeric_limits<int>::max();
-    const FacilityType *selected = nullptr;
-
-    for (const auto &facility : facilitiesOptions)
-    {
-        int scoreA = LifeQualityScore + facility.getLifeQualityScore();
-        int scoreB = EconomyScore + facility.getEconomyScore();
-        int scoreC = EnvironmentScore + facility.getEnvironmentScore();
-        int difference = max(abs(scoreA - scoreB), abs(scoreB - scoreC));
-        difference = max(difference, abs(scoreC - scoreA));
-        if (difference < minDifference)
-        {
-            minDifference = difference;
-            selected = &facility;
-        }
-    }
+    // The catalog's balance index finds the same type a scan for the smallest difference would
+    int position = facilitiesOptions.mostBalanced(LifeQualityScore, EconomyScore, EnvironmentScore);
+    const FacilityType *selected = position < 0 ? nullptr : &facilitiesOptions[position];
 
     if (!selected)
     {
@@ -46,6 +32,31 @@ const FacilityType &BalancedSelection::selectFacility(const vector<FacilityType>
     return *selected;
 }
 
+// Running totals the next pick is balanced against
+int BalancedSelection::getLifeQualityScore() const
+{
+    return LifeQualityScore;
+}
+
+int BalancedSelection::getEconomyScore() const
+{
+    return EconomyScore;
+}
+
+int BalancedSelection::getEnvironmentScore() const
+{
+    return EnvironmentScore;
+}
+
+// Select the next count facilities. Each pick changes the totals the next one balances against.
+void BalancedSelection::selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        positions[i] = static_cast<int>(&selectFacility(facilitiesOptions) - facilitiesOptions.data());
+    }
+}
+
 const string BalancedSelection::toString() const
 {
     return "bal";
@@ -56,6 +67,11 @@ const string BalancedSelection::getPolicyType() const
     return "bal";
 }
 
+int BalancedSelection::getCursor() const
+{
+    return -1; // Picks depend on the running scores, so the schedule is not a plain cycle
+}
+
 BalancedSelection *BalancedSelection::clone() const
 {
     return new BalancedSelection(*this);
@@ -1,31 +1,68 @@
 #include "SelectionPolicy.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
 using namespace std;
 
 // Constructor
-EconomySelection::EconomySelection() : lastSelectedIndex(-1) {}
+EconomySelection::EconomySelection() : SelectionPolicy(PolicyKind::ECONOMY), lastSelectedIndex(-1), nextCandidate(0) {}
+
+// Resume a round-robin from a saved position
+EconomySelection::EconomySelection(int lastSelectedIndex) : SelectionPolicy(PolicyKind::ECONOMY), lastSelectedIndex(lastSelectedIndex), nextCandidate(-1) {}
 
 // Select facility
-const FacilityType &EconomySelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+const FacilityType &EconomySelection::selectFacility(const FacilityCatalog &facilitiesOptions)
 {
     if (facilitiesOptions.empty())
     {
         cout << "No available facilities to select." << endl;
     }
 
-    for (size_t i = 0; i < facilitiesOptions.size(); ++i)
+    // The round-robin only visits this category, so it walks the catalog's list of its positions
+    const vector<int> &candidates = facilitiesOptions.ofCategory(FacilityCategory::ECONOMY);
+    if (candidates.empty())
+    {
+        throw std::runtime_error("No suitable facility found");
+    }
+    if (nextCandidate < 0)
+    {
+        nextCandidate = std::upper_bound(candidates.begin(), candidates.end(), lastSelectedIndex) - candidates.begin();
+    }
+    if (nextCandidate >= (int)candidates.size())
+    {
+        nextCandidate = 0;
+    }
+    lastSelectedIndex = candidates[nextCandidate++];
+    return facilitiesOptions[lastSelectedIndex];
+}
+
+// Select the next count facilities
+void EconomySelection::selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions)
+{
+    if (facilitiesOptions.empty())
     {
-        size_t index = (lastSelectedIndex + 1 + i) % facilitiesOptions.size();
-        if (facilitiesOptions[index].getCategory() == FacilityCategory::ECONOMY)
+        cout << "No available facilities to select." << endl;
+    }
+
+    const vector<int> &candidates = facilitiesOptions.ofCategory(FacilityCategory::ECONOMY);
+    if (candidates.empty())
+    {
+        throw std::runtime_error("No suitable facility found");
+    }
+    if (nextCandidate < 0)
+    {
+        nextCandidate = std::upper_bound(candidates.begin(), candidates.end(), lastSelectedIndex) - candidates.begin();
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        if (nextCandidate >= (int)candidates.size())
         {
-            lastSelectedIndex = index;
-            return facilitiesOptions[index];
+            nextCandidate = 0;
         }
+        lastSelectedIndex = candidates[nextCandidate++];
+        positions[i] = lastSelectedIndex;
     }
-
-    throw std::runtime_error("No suitable facility found");
 }
 
 // Convert to string
@@ -39,6 +76,11 @@ const string EconomySelection::getPolicyType() const
     return "eco";
 }
 
+int EconomySelection::getCursor() const
+{
+    return lastSelectedIndex + 1;
+}
+
 // Clone policy
 EconomySelection *EconomySelection::clone() const
 {
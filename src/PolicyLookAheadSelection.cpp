@@ -0,0 +1,176 @@
+#include "SelectionPolicy.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+const int LookAheadSelection::MAX_HORIZON;
+const int LookAheadSelection::MAX_WEIGHT;
+
+LookAheadSelection::LookAheadSelection(const LookAheadSettings &settings)
+    : SelectionPolicy(PolicyKind::LOOK_AHEAD), settings(settings), plannedCatalog(nullptr), plannedVersion(0), bestFirst(-1), pickCount(0), lastPickMicros(0), totalPickMicros(0) {}
+
+// The planned run is not copied; a copy plans again on its first pick
+LookAheadSelection::LookAheadSelection(const LookAheadSelection &other)
+    : SelectionPolicy(PolicyKind::LOOK_AHEAD), settings(other.settings), plannedCatalog(nullptr), plannedVersion(0), bestFirst(-1),
+      pickCount(other.pickCount), lastPickMicros(other.lastPickMicros), totalPickMicros(other.totalPickMicros) {}
+
+// Select facility
+const FacilityType &LookAheadSelection::selectFacility(const FacilityCatalog &facilitiesOptions)
+{
+    int position;
+    selectFacilities(facilitiesOptions, 1, &position);
+    return facilitiesOptions[position];
+}
+
+// Select the next count facilities. A slot is only filled when it is free, so every free slot has
+// the whole horizon ahead of it and starts the same best run.
+void LookAheadSelection::selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (facilitiesOptions.empty())
+    {
+        cout << "No available facilities to select." << endl;
+        throw std::runtime_error("No suitable facility found");
+    }
+    if (plannedCatalog != &facilitiesOptions || plannedVersion != facilitiesOptions.getVersion())
+    {
+        planRuns(facilitiesOptions);
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        positions[i] = bestFirst;
+    }
+
+    lastPickMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    totalPickMicros += lastPickMicros;
+    ++pickCount;
+}
+
+// Find the run of builds that completes the most weighted score within horizon steps, and remember its first type
+void LookAheadSelection::planRuns(const FacilityCatalog &facilitiesOptions)
+{
+    int horizon = settings.horizon;
+    // For each build time the highest scoring type, kept only if it scores more than every faster one;
+    // any other type can be swapped for a faster one that scores at least as much
+    vector<int> bestOfDuration(horizon + 1, -1);
+    vector<long long> values(facilitiesOptions.size());
+    int bestOverall = -1; // Built when nothing can finish in time
+    for (size_t i = 0; i < facilitiesOptions.size(); ++i)
+    {
+        const FacilityType &type = facilitiesOptions[i];
+        if (type.getCost() < 0)
+        {
+            continue; // A negative price never counts down to completion, so it would only block the slot
+        }
+        values[i] = (long long)settings.lifeQualityWeight * type.getLifeQualityScore() + (long long)settings.economyWeight * type.getEconomyScore() +
+                    (long long)settings.environmentWeight * type.getEnvironmentScore();
+        if (bestOverall < 0 || values[i] > values[bestOverall])
+        {
+            bestOverall = static_cast<int>(i);
+        }
+        int duration = std::max(type.getCost(), 1);
+        if (duration <= horizon && (bestOfDuration[duration] < 0 || values[i] > values[bestOfDuration[duration]]))
+        {
+            bestOfDuration[duration] = static_cast<int>(i);
+        }
+    }
+    vector<int> candidates;
+    long long fastestBest = 0;
+    for (int duration = 1; duration <= horizon; ++duration)
+    {
+        int position = bestOfDuration[duration];
+        if (position >= 0 && values[position] > fastestBest)
+        {
+            candidates.push_back(position);
+            fastestBest = values[position];
+        }
+    }
+
+    // bestRun[steps]: the most score a slot can complete in steps, and the type its run starts with
+    vector<long long> bestRun(horizon + 1, 0);
+    vector<int> firstOfRun(horizon + 1, -1);
+    for (int steps = 1; steps <= horizon; ++steps)
+    {
+        for (int position : candidates)
+        {
+            int duration = std::max(facilitiesOptions[position].getCost(), 1);
+            if (duration > steps)
+            {
+                break; // Candidates are by ascending build time
+            }
+            long long value = values[position] + bestRun[steps - duration];
+            if (value > bestRun[steps])
+            {
+                bestRun[steps] = value;
+                firstOfRun[steps] = position;
+            }
+        }
+    }
+
+    // When every type has a negative price none of them ever finishes, so any will do
+    bestFirst = firstOfRun[horizon] >= 0 ? firstOfRun[horizon] : std::max(bestOverall, 0);
+    plannedCatalog = &facilitiesOptions;
+    plannedVersion = facilitiesOptions.getVersion();
+}
+
+int LookAheadSelection::getHorizon() const
+{
+    return settings.horizon;
+}
+
+const LookAheadSettings &LookAheadSelection::getSettings() const
+{
+    return settings;
+}
+
+bool LookAheadSelection::isValid(const LookAheadSettings &settings)
+{
+    auto validWeight = [](int weight)
+    { return weight >= 0 && weight <= MAX_WEIGHT; };
+    return settings.horizon >= 1 && settings.horizon <= MAX_HORIZON && validWeight(settings.lifeQualityWeight) &&
+           validWeight(settings.economyWeight) && validWeight(settings.environmentWeight);
+}
+
+// How long picks have taken, for planStatus
+const string LookAheadSelection::getPickTimes() const
+{
+    if (pickCount == 0)
+    {
+        return "no picks yet";
+    }
+    ostringstream times;
+    times << fixed << setprecision(1) << "last " << lastPickMicros << "us, mean " << totalPickMicros / pickCount << "us over " << pickCount << " picks";
+    return times.str();
+}
+
+// "opt <horizon>", with the weights only when they are not all 1
+const string LookAheadSelection::toString() const
+{
+    string name = "opt " + to_string(settings.horizon);
+    if (settings.lifeQualityWeight != 1 || settings.economyWeight != 1 || settings.environmentWeight != 1)
+    {
+        name += " " + to_string(settings.lifeQualityWeight) + " " + to_string(settings.economyWeight) + " " + to_string(settings.environmentWeight);
+    }
+    return name;
+}
+
+const string LookAheadSelection::getPolicyType() const
+{
+    return toString();
+}
+
+int LookAheadSelection::getCursor() const
+{
+    return 0; // Picks depend only on the construction slots, so the schedule cycles like a round-robin's
+}
+
+LookAheadSelection *LookAheadSelection::clone() const
+{
+    return new LookAheadSelection(*this);
+}
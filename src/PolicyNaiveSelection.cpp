@@ -5,10 +5,13 @@
 using namespace std;
 
 // Constructor
-NaiveSelection::NaiveSelection() : lastSelectedIndex(-1) {}
+NaiveSelection::NaiveSelection() : SelectionPolicy(PolicyKind::NAIVE), lastSelectedIndex(-1) {}
+
+// Resume a round-robin from a saved position
+NaiveSelection::NaiveSelection(int lastSelectedIndex) : SelectionPolicy(PolicyKind::NAIVE), lastSelectedIndex(lastSelectedIndex) {}
 
 // Select facility
-const FacilityType &NaiveSelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+const FacilityType &NaiveSelection::selectFacility(const FacilityCatalog &facilitiesOptions)
 {
     if (facilitiesOptions.empty())
     {
@@ -18,6 +21,20 @@ const FacilityType &NaiveSelection::selectFacility(const vector<FacilityType> &f
     return facilitiesOptions[lastSelectedIndex];
 }
 
+// Select the next count facilities
+void NaiveSelection::selectFacilities(const FacilityCatalog &facilitiesOptions, int count, int *positions)
+{
+    if (facilitiesOptions.empty())
+    {
+        cout << "No available facilities to select." << endl;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        lastSelectedIndex = (lastSelectedIndex + 1) % facilitiesOptions.size();
+        positions[i] = lastSelectedIndex;
+    }
+}
+
 // Convert to string
 const string NaiveSelection::toString() const
 {
@@ -28,6 +45,12 @@ const string NaiveSelection::getPolicyType() const
 {
     return "nav";
 }
+
+int NaiveSelection::getCursor() const
+{
+    return lastSelectedIndex + 1;
+}
+
 // Clone policy
 NaiveSelection *NaiveSelection::clone() const
 {
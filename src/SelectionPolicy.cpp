@@ -0,0 +1,59 @@
+#include "SelectionPolicy.h"
+#include "Auxiliary.h"
+
+using namespace std;
+
+SelectionPolicy::SelectionPolicy(PolicyKind kind) : kind(kind) {}
+
+bool SelectionPolicy::kindOf(const string &name, PolicyKind &kind, LookAheadSettings &settings)
+{
+    static const struct
+    {
+        const char *name;
+        PolicyKind kind;
+    } names[] = {{"nve", PolicyKind::NAIVE}, {"bal", PolicyKind::BALANCED}, {"eco", PolicyKind::ECONOMY}, {"env", PolicyKind::SUSTAINABILITY}};
+
+    settings = LookAheadSettings{0, 1, 1, 1};
+    for (const auto &entry : names)
+    {
+        if (name == entry.name)
+        {
+            kind = entry.kind;
+            return true;
+        }
+    }
+
+    // "opt <horizon>", optionally followed by the three weights
+    ArgumentView arguments[6];
+    int count = Auxiliary::splitArguments(name.data(), name.data() + name.size(), arguments, 6);
+    bool parsed = (count == 2 || count == 5) && arguments[0] == "opt" && Auxiliary::parseInt(arguments[1], settings.horizon);
+    if (parsed && count == 5)
+    {
+        parsed = Auxiliary::parseInt(arguments[2], settings.lifeQualityWeight) && Auxiliary::parseInt(arguments[3], settings.economyWeight) &&
+                 Auxiliary::parseInt(arguments[4], settings.environmentWeight);
+    }
+    if (!parsed || !LookAheadSelection::isValid(settings))
+    {
+        settings = LookAheadSettings{0, 1, 1, 1};
+        return false;
+    }
+    kind = PolicyKind::LOOK_AHEAD;
+    return true;
+}
+
+SelectionPolicy *SelectionPolicy::create(PolicyKind kind, int lifeQualityScore, int economyScore, int environmentScore, const LookAheadSettings &settings)
+{
+    switch (kind)
+    {
+    case PolicyKind::LOOK_AHEAD:
+        return new LookAheadSelection(settings);
+    case PolicyKind::BALANCED:
+        return new BalancedSelection(lifeQualityScore, economyScore, environmentScore);
+    case PolicyKind::ECONOMY:
+        return new EconomySelection();
+    case PolicyKind::SUSTAINABILITY:
+        return new SustainabilitySelection();
+    default:
+        return new NaiveSelection();
+    }
+}
@@ -3,173 +3,72 @@
 #include "Plan.h"
 #include "SelectionPolicy.h"
 #include "Action.h"
+#include "OutputBuffer.h"
+#include "Commands.h"
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 #include <sstream>
 #include <limits> // For numeric_limits
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
 Simulation *backupSim = nullptr;
-// Constructor: Initialize simulation and parse the configuration file
-Simulation::Simulation(const string &configFilePath) : isRunning(false), planCounter(0), actionsLog(), plans(), settlements(), facilitiesOptions()
-{
-    ifstream configFile(configFilePath);
 
-    if (!configFile.is_open())
-    {
-        throw runtime_error("Failed to open configuration file: " + configFilePath);
-    }
+namespace
+{
+    const size_t CHECKPOINT_INTERVAL = 1000; // Actions between checkpoints, doubled each time they are thinned out
+    const size_t MAX_CHECKPOINTS = 64;       // Counting the ones taken after a restore, load or rewind
 
-    string line;
-    while (getline(configFile, line))
+    // Sends std::cout nowhere while it exists, for replaying actions
+    class SilenceOutput
     {
-        vector<string> args = Auxiliary::parseArguments(line);
-
-        if (args.empty())
-            continue;
-
-        if (args[0] == "settlement" && args.size() == 3)
-        {
-            string name = args[1];
-            int type = stoi(args[2]);
-            SettlementType settlementType;
-
-            switch (type)
-            {
-            case 0:
-                settlementType = SettlementType::VILLAGE;
-                break;
-            case 1:
-                settlementType = SettlementType::CITY;
-                break;
-            case 2:
-                settlementType = SettlementType::METROPOLIS;
-                break;
-            default:
-                cout << "Invalid settlement type in line: " << line << endl;
-                continue;
-            }
-
-            Settlement *settlement = new Settlement(name, settlementType);
-            if (!addSettlement(settlement))
-            {
-                delete settlement;
-                cout << "Duplicate settlement: " << name << endl;
-            }
-        }
-        else if (args[0] == "facility" && args.size() == 7)
-        {
-            string name = args[1];
-            int category = stoi(args[2]);
-            int price = stoi(args[3]);
-            int lifeQualityScore = stoi(args[4]);
-            int economyScore = stoi(args[5]);
-            int environmentScore = stoi(args[6]);
-
-            FacilityCategory facilityCategory;
-            switch (category)
-            {
-            case 0:
-                facilityCategory = FacilityCategory::LIFE_QUALITY;
-                break;
-            case 1:
-                facilityCategory = FacilityCategory::ECONOMY;
-                break;
-            case 2:
-                facilityCategory = FacilityCategory::ENVIRONMENT;
-                break;
-            default:
-                cout << "Invalid facility category in line: " << line << endl;
-                continue;
-            }
+    public:
+        SilenceOutput() : saved(std::cout.rdbuf(nullptr)) {}
+        SilenceOutput(const SilenceOutput &other) = delete;
+        SilenceOutput &operator=(const SilenceOutput &other) = delete;
+        ~SilenceOutput() { std::cout.rdbuf(saved); }
+
+    private:
+        std::streambuf *saved;
+    };
+}
 
-            FacilityType facility(name, facilityCategory, price, lifeQualityScore, economyScore, environmentScore);
-            if (!addFacility(facility))
-            {
-                cout << "Duplicate facility: " << name << endl;
-            }
-        }
-        else if (args[0] == "plan" && args.size() == 3)
-        {
-            string settlementName = args[1];
-            string policyType = args[2];
-            if (isSettlementExists(settlementName))
-            {
-                Settlement &settlement = getSettlement(settlementName);
-                SelectionPolicy *policy = nullptr;
-                if (policyType == "nve")
-                {
-                    policy = new NaiveSelection();
-                }
-                else if (policyType == "bal")
-                {
-                    policy = new BalancedSelection(0, 0, 0);
-                }
-                else if (policyType == "eco")
-                {
-                    policy = new EconomySelection();
-                }
-                else if (policyType == "env")
-                {
-                    policy = new SustainabilitySelection();
-                }
-                else
-                {
-                    cout << "Invalid selection policy in line: " << line << endl;
-                    continue;
-                }
-                addPlan(settlement, policy);
-            }
-            else
-            {
-                cout << "Settlement: " + settlementName + " do not exists" << endl;
-            }
-        }
-        else
-        {
-            cout << "Invalid line format: " << line << endl;
-        }
-    }
+// Constructor: Initialize simulation and parse the configuration file
+Simulation::Simulation(const string &configFilePath) : Simulation(configFilePath, 1) {}
 
-    configFile.close();
+// Same, splitting the config parsing (and later steps) across workerCount threads
+Simulation::Simulation(const string &configFilePath, int workerCount) : isRunning(false), planCounter(0), actionsLog(), plans(std::make_shared<vector<std::shared_ptr<Plan>>>()), settlements(), facilitiesOptions(), workerPool(), checkpoints(), checkpointInterval(CHECKPOINT_INTERVAL)
+{
+    setWorkerCount(workerCount);
+    loadConfig(configFilePath);
+    checkpoint(true); // Rewinding can go back to the loaded config
 }
 
+// Copying a simulation (a backup) is O(1): the copy shares the append-only stores and the plans,
+// and either side copies a plan only when it is about to change it.
 Simulation::Simulation(const Simulation &other)
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
-      actionsLog(),
-      plans(),
-      settlements(),
-      facilitiesOptions(other.facilitiesOptions)
+      actionsLog(other.actionsLog),
+      plans(other.plans),
+      settlements(other.settlements),
+      facilitiesOptions(other.facilitiesOptions),
+      workerPool(other.workerPool),
+      checkpoints(),
+      checkpointInterval(CHECKPOINT_INTERVAL)
 {
-    // Deep copy actionsLog
-    actionsLog.reserve(other.actionsLog.size());
-    for (auto *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    settlements.reserve(other.settlements.size());
-    for (Settlement *sett : other.settlements)
-    {
-        settlements.push_back(new Settlement(*sett));
-    }
-
-    // Now that we have our copied settlements and have facilitiesOptions copied,
-    // we can deep copy each plan using Plan::cloneDeep().
-    plans.reserve(other.plans.size());
-    for (const auto &plan : other.plans)
-    {
-        // cloneDeep will find the corresponding settlement inside 'settlements'
-        // and create a fully deep-copied Plan.
-        Plan newPlan = plan.cloneDeep(settlements, facilitiesOptions);
-        plans.push_back(std::move(newPlan));
-    }
 }
 
+// Restoring a backup shares its state again; entries appended since the backup are dropped.
 Simulation &Simulation::operator=(const Simulation &other)
 {
     if (this == &other)
@@ -177,53 +76,14 @@ Simulation &Simulation::operator=(const Simulation &other)
         return *this; // Self-assignment check
     }
 
-    // Cleanup current resources
-    for (auto *action : actionsLog)
-    {
-        delete action;
-    }
-    actionsLog.clear();
+    // Release our plans first, they refer to settlements and facility types that may be dropped
+    plans = other.plans;
 
-    for (auto *settlement : settlements)
-    {
-        delete settlement;
-    }
-    settlements.clear();
-
-    plans.clear();
-    facilitiesOptions.clear();
-
-    // Copy simple fields
     isRunning = other.isRunning;
     planCounter = other.planCounter;
-
-    for (const FacilityType &facility : other.facilitiesOptions)
-    {
-        facilitiesOptions.push_back(facility); // Uses copy constructor
-    }
-
-    // Deep copy actionsLog
-    actionsLog.reserve(other.actionsLog.size());
-    for (auto *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    settlements.reserve(other.settlements.size());
-    for (Settlement *sett : other.settlements)
-    {
-        settlements.push_back(new Settlement(*sett));
-    }
-
-    // Deep copy plans using Plan::cloneDeep()
-    plans.reserve(other.plans.size());
-    for (const auto &plan : other.plans)
-    {
-        // Use cloneDeep for a fully deep-copied Plan
-        Plan newPlan = plan.cloneDeep(settlements, facilitiesOptions);
-        plans.push_back(std::move(newPlan));
-    }
+    actionsLog = other.actionsLog;
+    settlements = other.settlements;
+    facilitiesOptions = other.facilitiesOptions;
 
     return *this;
 }
@@ -231,10 +91,13 @@ Simulation &Simulation::operator=(const Simulation &other)
 Simulation::Simulation(Simulation &&other) noexcept
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
-      actionsLog(std::move(other.actionsLog)),
+      actionsLog(other.actionsLog),
       plans(std::move(other.plans)),
-      settlements(std::move(other.settlements)),
-      facilitiesOptions(std::move(other.facilitiesOptions))
+      settlements(other.settlements),
+      facilitiesOptions(other.facilitiesOptions),
+      workerPool(std::move(other.workerPool)),
+      checkpoints(std::move(other.checkpoints)),
+      checkpointInterval(other.checkpointInterval)
 {
     other.isRunning = false;
     other.planCounter = 0;
@@ -244,12 +107,15 @@ Simulation &Simulation::operator=(Simulation &&other) noexcept
 {
     if (this != &other)
     {
+        plans = std::move(other.plans);
         isRunning = other.isRunning;
         planCounter = other.planCounter;
-        actionsLog = std::move(other.actionsLog);
-        plans = std::move(other.plans);
-        settlements = std::move(other.settlements);
-        facilitiesOptions = std::move(other.facilitiesOptions);
+        actionsLog = other.actionsLog;
+        settlements = other.settlements;
+        facilitiesOptions = other.facilitiesOptions;
+        workerPool = std::move(other.workerPool);
+        checkpoints = std::move(other.checkpoints);
+        checkpointInterval = other.checkpointInterval;
 
         other.isRunning = false;
         other.planCounter = 0;
@@ -264,18 +130,9 @@ Simulation::~Simulation()
 
 void Simulation::clear()
 {
-    for (BaseAction *action : actionsLog)
-    {
-        delete action;
-    }
+    plans.reset();
     actionsLog.clear();
-
-    for (Settlement *settlement : settlements)
-    {
-        delete settlement;
-    }
     settlements.clear();
-    plans.clear();
     facilitiesOptions.clear();
 }
 
@@ -291,91 +148,349 @@ void Simulation::start()
     {
         std::cout << "> ";
         std::getline(std::cin, command);
+        runCommand(command.data(), command.data() + command.size());
+    }
+}
 
-        vector<string> args = Auxiliary::parseArguments(command);
+// Run the commands in commandsPath ("-" for standard input) without prompts, collecting the output
+// in one buffer that is written out when full, at "sync" commands and at the end, also when a command
+// throws: an exception nobody catches may end the program without destroying the buffer
+void Simulation::startBatch(const string &commandsPath)
+{
+    isRunning = true;
+    OutputBuffer output(std::cout);
+    std::cout << "The simulation has started" << std::endl;
 
-        if (args.empty())
-            continue;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long commands;
+    try
+    {
+        commands = runScript(commandsPath);
+    }
+    catch (...)
+    {
+        output.drain();
+        throw;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-        // Match commands and execute actions
-        BaseAction *action = nullptr;
+    output.drain();
+    std::cerr << "Ran " << commands << " commands in " << seconds << " s (" << (seconds > 0 ? commands / seconds : 0) << " commands/s)" << std::endl;
+}
 
-        if (args[0] == "step" && args.size() == 2)
-        {
-            int steps = std::stoi(args[1]);
-            action = new SimulateStep(steps);
-        }
-        else if (args[0] == "plan" && args.size() == 3)
+// Run the commands in path ("-" for standard input) until they end or one closes the simulation.
+// The input is read in large blocks, so a pipe works as well as a file. Returns how many commands ran.
+long long Simulation::runScript(const string &path)
+{
+    int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+
+    vector<char> block(1 << 20);
+    size_t kept = 0; // Bytes of an unfinished line at the start of block
+    long long commands = 0;
+    bool atEnd = false;
+    while (isRunning && !atEnd)
+    {
+        if (kept == block.size())
         {
-            action = new AddPlan(args[1], args[2]);
+            block.resize(block.size() * 2); // A line longer than the block
         }
-        else if (args[0] == "settlement" && args.size() == 3)
+        ssize_t count = read(fd, block.data() + kept, block.size() - kept);
+        if (count < 0 && errno == EINTR)
         {
-            SettlementType type = static_cast<SettlementType>(std::stoi(args[2]));
-            action = new AddSettlement(args[1], type);
+            continue;
         }
-        else if (args[0] == "facility" && args.size() == 7)
+        atEnd = count <= 0;
+        size_t filled = kept + (count > 0 ? static_cast<size_t>(count) : 0);
+
+        const char *lineStart = block.data();
+        const char *blockEnd = block.data() + filled;
+        while (isRunning)
         {
-            FacilityCategory category = static_cast<FacilityCategory>(std::stoi(args[2]));
-            int price = std::stoi(args[3]);
-            int lifeQualityScore = std::stoi(args[4]);
-            int economyScore = std::stoi(args[5]);
-            int environmentScore = std::stoi(args[6]);
-            action = new AddFacility(args[1], category, price, lifeQualityScore, economyScore, environmentScore);
+            const char *lineEnd = static_cast<const char *>(memchr(lineStart, '\n', blockEnd - lineStart));
+            if (lineEnd == nullptr)
+            {
+                if (!atEnd || lineStart == blockEnd)
+                {
+                    break;
+                }
+                lineEnd = blockEnd; // The last line has no newline
+            }
+            if (runCommand(lineStart, lineEnd))
+            {
+                ++commands;
+            }
+            lineStart = lineEnd == blockEnd ? blockEnd : lineEnd + 1;
         }
-        else if (args[0] == "planStatus" && args.size() == 2)
+        kept = blockEnd - lineStart;
+        std::memmove(block.data(), lineStart, kept);
+    }
+
+    if (fd != STDIN_FILENO)
+    {
+        ::close(fd);
+    }
+    return commands;
+}
+
+// Parse one command line, run its action and log it. Returns false for a blank line.
+// The line is split in place and the action is built on the stack, so this allocates nothing
+// beyond what the action itself needs.
+bool Simulation::runCommand(const char *begin, const char *end)
+{
+    ArgumentView args[MAX_COMMAND_ARGUMENTS];
+    int argCount = Auxiliary::splitArguments(begin, end, args, MAX_COMMAND_ARGUMENTS);
+    if (argCount == 0)
+        return false;
+
+    if (args[0] == "sync" && argCount == 1)
+    {
+        // A sync point, not an action: write out what batch mode has collected so far
+        OutputBuffer *output = dynamic_cast<OutputBuffer *>(std::cout.rdbuf());
+        if (output != nullptr)
         {
-            int planID = std::stoi(args[1]);
-            action = new PrintPlanStatus(planID);
+            output->drain();
         }
-        else if (args[0] == "changePolicy" && args.size() == 3)
+        std::cout.flush();
+        return true;
+    }
+
+    const Command *command = findCommand(args, argCount);
+    ActionStorage storage;
+    BaseAction *action = command ? command->build(args, &storage) : nullptr;
+    if (!action)
+    {
+        std::cout << "Unknown command: ";
+        std::cout.write(args[0].begin, args[0].length) << std::endl;
+        return true;
+    }
+
+    // Execute the action and add it to the log; the log keeps a packed copy, not the action
+    std::unique_ptr<BaseAction, void (*)(BaseAction *)> destroy(action, [](BaseAction *built)
+                                                                { built->~BaseAction(); });
+    action->act(*this);
+    action->record(actionsLog);
+    afterAction(command->replacesState);
+    return true;
+}
+
+// Take a checkpoint when the last one is checkpointInterval actions back. After an action that replaced
+// the state, the checkpoints past the log (from the discarded history) go, and one is taken right away.
+void Simulation::afterAction(bool replacedState)
+{
+    if (replacedState)
+    {
+        while (!checkpoints.empty() && checkpoints.back().actionIndex >= actionsLog.size())
         {
-            int planID = std::stoi(args[1]);
-            action = new ChangePlanPolicy(planID, args[2]);
+            checkpoints.pop_back();
         }
-        else if (args[0] == "log" && args.size() == 1)
+        checkpoint(true);
+    }
+    else if (checkpoints.empty() || actionsLog.size() - checkpoints.back().actionIndex >= checkpointInterval)
+    {
+        checkpoint(false);
+    }
+}
+
+// Remember the current state. Copies are O(1), but every plan changed after this is copied once,
+// so past MAX_CHECKPOINTS every other regular one is dropped and they are taken half as often.
+// Barriers cannot be thinned out (replay cannot cross the action before them), so when they fill
+// the room the oldest checkpoints go, and rewinding can no longer reach that far back.
+void Simulation::checkpoint(bool barrier)
+{
+    checkpoints.push_back(Checkpoint{actionsLog.size(), barrier, std::make_shared<Simulation>(*this)});
+    if (checkpoints.size() <= MAX_CHECKPOINTS)
+    {
+        return;
+    }
+
+    size_t regular = 0;
+    for (const Checkpoint &checkpoint : checkpoints)
+    {
+        regular += checkpoint.barrier ? 0 : 1;
+    }
+    if (regular > MAX_CHECKPOINTS / 2)
+    {
+        size_t kept = 0;
+        bool drop = false;
+        for (size_t i = 0; i < checkpoints.size(); ++i)
         {
-            action = new PrintActionsLog();
+            if (!checkpoints[i].barrier && i + 1 < checkpoints.size() && (drop = !drop))
+            {
+                continue;
+            }
+            checkpoints[kept++] = std::move(checkpoints[i]);
         }
-        else if (args[0] == "backup" && args.size() == 1)
+        checkpoints.erase(checkpoints.begin() + kept, checkpoints.end());
+        checkpointInterval *= 2;
+    }
+    if (checkpoints.size() > MAX_CHECKPOINTS)
+    {
+        checkpoints.erase(checkpoints.begin(), checkpoints.end() - MAX_CHECKPOINTS);
+    }
+}
+
+/*
+Go back to the state after the first actionIndex actions: copy the last checkpoint at or before it
+and replay the logged actions in between on the copy, with their output silenced. Replay only goes
+forward from a checkpoint; restore, load and rewind are always followed by one, so they never need
+replaying. If replay fails, this simulation, its checkpoints and the backup are left as they were:
+the copy has a log and settlements of its own, and the facility types dropped from the catalog they
+share (plans refer to it) are added back. A replayed backup action takes the backup again; a backup
+that sees facility types the rewound simulation does not have is dropped.
+*/
+void Simulation::rewind(int actionIndex)
+{
+    if (actionIndex < 0 || static_cast<size_t>(actionIndex) > actionsLog.size())
+    {
+        throw std::runtime_error("No action " + to_string(actionIndex));
+    }
+    size_t target = static_cast<size_t>(actionIndex);
+    auto found = std::upper_bound(checkpoints.begin(), checkpoints.end(), target, [](size_t index, const Checkpoint &checkpoint)
+                                  { return index < checkpoint.actionIndex; });
+    if (found == checkpoints.begin())
+    {
+        throw std::runtime_error("No checkpoint before action " + to_string(actionIndex));
+    }
+    --found;
+    std::shared_ptr<const Simulation> from = found->state;
+    size_t start = found->actionIndex;
+    vector<JournalEntry> entries = actionsLog.entriesAfter(from->actionsLog, target - start);
+    if (entries.size() != target - start)
+    {
+        throw std::runtime_error("The log is missing actions after " + to_string(start + entries.size()));
+    }
+
+    Simulation replayed(*from);
+    replayed.detach();
+    replayed.isRunning = isRunning;
+    replayed.workerPool = workerPool;
+    replayed.checkpoints.assign(checkpoints.begin(), found + 1);
+    replayed.checkpointInterval = checkpointInterval;
+    vector<FacilityType> laterTypes; // Ours past the checkpoint's, dropped from the shared catalog below
+    bool sharedCatalog = facilitiesOptions.shares(from->facilitiesOptions);
+    if (sharedCatalog)
+    {
+        for (size_t i = from->facilitiesOptions.size(); i < facilitiesOptions.size(); ++i)
         {
-            action = new BackupSimulation();
+            laterTypes.push_back(facilitiesOptions[i]);
         }
-        else if (args[0] == "restore" && args.size() == 1)
+    }
+    replayed.facilitiesOptions = from->facilitiesOptions; // Drops them, so the checkpoint's plans do not see them
+    std::unique_ptr<Simulation> backup;                   // Taken again by a replayed backup action
+    try
+    {
+        SilenceOutput silence;
+        for (size_t i = 0; i < entries.size(); ++i)
         {
-            action = new RestoreSimulation();
+            replayed.replay(entries[i], start + i, backup);
         }
-        else if (args[0] == "close" && args.size() == 1)
+    }
+    catch (...)
+    {
+        if (sharedCatalog)
         {
-            action = new Close();
+            facilitiesOptions = from->facilitiesOptions;
+            for (const FacilityType &type : laterTypes)
+            {
+                facilitiesOptions.add(type.getName(), type);
+            }
         }
-        else
+        throw;
+    }
+
+    *this = replayed;
+    checkpoints = std::move(replayed.checkpoints); // The later ones go with the history they were taken in
+    checkpointInterval = replayed.checkpointInterval;
+    if (backup)
+    {
+        delete backupSim;
+        backupSim = backup.release();
+    }
+    else if (backupSim != nullptr && backupSim->facilitiesOptions.shares(facilitiesOptions) &&
+             backupSim->facilitiesOptions.size() > facilitiesOptions.size())
+    {
+        // The next facility added here would take the place of a type the backup's plans refer to
+        delete backupSim;
+        backupSim = nullptr;
+        std::cout << "Discarded the backup, it has facility types from after action " << target << std::endl;
+    }
+    std::cout << "Rewound to action " << target << ", replayed " << entries.size() << " actions from the checkpoint at action " << start << std::endl;
+}
+
+// Run a logged action again, or only log it again if it did not change the simulation. A backup
+// action leaves its copy in backup.
+void Simulation::replay(const JournalEntry &entry, size_t actionIndex, std::unique_ptr<Simulation> &backup)
+{
+    switch (entry.code)
+    {
+    case ActionCode::STEP:
+    case ActionCode::PLAN:
+    case ActionCode::SETTLEMENT:
+    case ActionCode::FACILITY:
+    case ActionCode::CHANGE_POLICY:
+    case ActionCode::AUTOTUNE:
+    {
+        string line = entry.command();
+        ArgumentView args[MAX_COMMAND_ARGUMENTS];
+        int argCount = Auxiliary::splitArguments(line.data(), line.data() + line.size(), args, MAX_COMMAND_ARGUMENTS);
+        const Command *command = findCommand(args, argCount);
+        ActionStorage storage;
+        BaseAction *action = command ? command->build(args, &storage) : nullptr;
+        if (!action)
         {
-            std::cout << "Unknown command: " << args[0] << std::endl;
-            continue;
+            throw std::runtime_error("Cannot replay action " + to_string(actionIndex) + ": " + line);
         }
-
-        // Execute the action and add to the log
-        if (action)
+        std::unique_ptr<BaseAction, void (*)(BaseAction *)> destroy(action, [](BaseAction *built)
+                                                                    { built->~BaseAction(); });
+        action->act(*this);
+        if ((action->getStatus() == ActionStatus::COMPLETED) != entry.completed)
         {
-            action->act(*this);
-            actionsLog.push_back(action);
-            // std::cout << action->toString() << std::endl;
+            throw std::runtime_error("Replay diverged at action " + to_string(actionIndex) + ": " + line);
         }
+        action->record(actionsLog);
+        break;
+    }
+    case ActionCode::BACKUP:
+        // The backup is not part of the simulation, but rewinding past it goes back to the one taken here
+        backup.reset(clone());
+        actionsLog.append(entry);
+        break;
+    case ActionCode::RESTORE:
+    case ActionCode::LOAD:
+    case ActionCode::REWIND:
+        throw std::runtime_error("Cannot replay action " + to_string(actionIndex) + ": " + entry.command());
+    default:
+        // planStatus, compare and log only print; save and source act outside the simulation
+        // (a source's commands are logged on their own before it)
+        actionsLog.append(entry);
+        break;
     }
+    afterAction(false);
+}
+
+// Stop sharing the log and the settlements with copies that appended past what this simulation sees
+// (see SharedStore::detach). Plans refer to the facility catalog, so it stays shared.
+void Simulation::detach()
+{
+    actionsLog.detach();
+    settlements.detach();
 }
 
 // Add a plan to the simulation
 void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy)
 {
-    Plan plan(planCounter++, settlement, selectionPolicy, facilitiesOptions);
-    plans.push_back(plan);
+    ownPlans().push_back(std::make_shared<Plan>(planCounter++, settlement, selectionPolicy, facilitiesOptions.items()));
 }
 
-// Add an action (not fully implemented)
+// Log an action that ran outside runCommand(); the simulation takes it over
 void Simulation::addAction(BaseAction *action)
 {
-    actionsLog.push_back(action);
+    action->record(actionsLog);
+    delete action;
 }
 
 // Add a settlement to the simulation
@@ -385,73 +500,86 @@ bool Simulation::addSettlement(Settlement *settlement)
     {
         return false;
     }
-    settlements.push_back(settlement);
+    settlements.add(settlement->getName(), std::shared_ptr<Settlement>(settlement));
     return true;
 }
 
 // Add a facility type to the simulation
 bool Simulation::addFacility(FacilityType facility)
 {
-    for (const auto &existingFacility : facilitiesOptions)
-    {
-        if (existingFacility.getName() == facility.getName())
-        {
-            return false; // Duplicate facility
-        }
-    }
-    facilitiesOptions.push_back(facility);
-    return true;
+    return facilitiesOptions.add(facility.getName(), facility); // False for a duplicate facility
 }
 
 // Check if a settlement exists
 bool Simulation::isSettlementExists(const string &settlementName)
 {
-    for (const auto &settlement : settlements)
-    {
-        if (settlement->getName() == settlementName)
-        {
-            return true;
-        }
-    }
-    return false;
+    return settlements.find(settlementName) >= 0;
 }
 
+// Plan IDs are handed out in order, so a plan's ID is its position in plans
 bool Simulation::isPlanExists(const int planID)
 {
-    if (planID > planCounter - 1)
-    {
-        return false;
-    }
-    return true;
+    return planID >= 0 && planID < (int)plans->size();
+}
+
+int Simulation::getPlanCount() const
+{
+    return static_cast<int>(plans->size());
 }
 
 // Retrieve a settlement by name
 Settlement &Simulation::getSettlement(const string &settlementName)
 {
-    for (auto &settlement : settlements)
+    int index = settlements.find(settlementName);
+    if (index < 0)
     {
-        if (settlement->getName() == settlementName)
-        {
-            return *settlement;
-        }
+        throw std::runtime_error("Settlement not found");
     }
-    throw std::runtime_error("Settlement not found");
+    return *settlements[index];
 }
 
-// Retrieve a plan by ID
+// Retrieve a plan by ID. The caller may change it, so it is no longer shared with a backup afterwards.
 Plan &Simulation::getPlan(const int planID)
 {
-    for (auto &plan : plans)
+    if (!isPlanExists(planID))
     {
-        if (plan.getPlanId() == planID)
-        {
-            return plan;
-        }
+        throw std::runtime_error("Plan not found: " + to_string(planID));
     }
-    throw std::runtime_error("Plan not found: " + to_string(planID));
+    return ownPlan(planID);
 }
 
-const std::vector<BaseAction *> &Simulation::getActionsLog() const
+// Look at a plan without taking it over from a backup
+const Plan &Simulation::getPlan(const int planID) const
+{
+    if (planID < 0 || planID >= (int)plans->size())
+    {
+        throw std::runtime_error("Plan not found: " + to_string(planID));
+    }
+    return *(*plans)[planID];
+}
+
+// The plans, copied first if a backup still shares the list
+vector<std::shared_ptr<Plan>> &Simulation::ownPlans()
+{
+    if (plans.use_count() > 1)
+    {
+        plans = std::make_shared<vector<std::shared_ptr<Plan>>>(*plans);
+    }
+    return *plans;
+}
+
+// One plan, copied first if a backup still shares it
+Plan &Simulation::ownPlan(int planID)
+{
+    std::shared_ptr<Plan> &plan = ownPlans()[planID];
+    if (plan.use_count() > 1)
+    {
+        plan = std::make_shared<Plan>(*plan);
+    }
+    return *plan;
+}
+
+const ActionJournal &Simulation::getActionsLog() const
 {
     return actionsLog;
 }
@@ -459,18 +587,68 @@ const std::vector<BaseAction *> &Simulation::getActionsLog() const
 // Step through the simulation
 void Simulation::step()
 {
-    for (auto &plan : plans)
+    step(1);
+}
+
+// Step through the simulation numOfSteps times. Plans never interact, so each one
+// is advanced on its own and only pays for the steps where a facility starts or finishes.
+void Simulation::step(int numOfSteps)
+{
+    // Every plan changes, so take private copies of any still shared with a backup
+    for (int i = 0; i < (int)plans->size(); ++i)
+    {
+        ownPlan(i);
+    }
+
+    if (!workerPool || workerPool->size() < 2 || plans->size() < 2)
+    {
+        for (auto &plan : *plans)
+        {
+            plan->step(numOfSteps);
+        }
+        return;
+    }
+
+    // Plans only read the shared facilitiesOptions and touch their own facilities,
+    // so each chunk of plans can be stepped on its own worker
+    workerPool->parallelFor(plans->size(), [this, numOfSteps](size_t begin, size_t end)
+                            {
+        for (size_t i = begin; i < end; ++i)
+        {
+            (*plans)[i]->step(numOfSteps);
+        } });
+}
+
+// Run task over chunks of [0, count) on the worker pool, or all of it on this thread without one
+void Simulation::parallelFor(size_t count, const std::function<void(size_t, size_t)> &task) const
+{
+    if (workerPool && workerPool->size() > 1 && count > 1)
+    {
+        workerPool->parallelFor(count, task);
+    }
+    else
+    {
+        task(0, count);
+    }
+}
+
+// Set how many threads step() splits the plans across (1 = serial)
+void Simulation::setWorkerCount(int workerCount)
+{
+    if (workerCount < 2)
     {
-        plan.step();
+        workerPool.reset();
+        return;
     }
+    workerPool = std::make_shared<ThreadPool>(workerCount);
 }
 
 // Close the simulation
 void Simulation::close()
 {
-    for (auto &plan : plans)
+    for (auto &plan : *plans)
     {
-        plan.printShortStatus();
+        plan->printShortStatus();
     }
     isRunning = false;
 }
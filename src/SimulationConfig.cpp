@@ -0,0 +1,353 @@
+#include "Simulation.h"
+#include "Auxiliary.h"
+#include "MappedFile.h"
+#include "SelectionPolicy.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/*
+Config loading runs in passes so that the expensive parts can be split across the worker pool:
+1. (parallel) The file is cut into line-aligned shards and every line is split and classified.
+2. (serial)   Settlements and facility types are added in file order, detecting duplicates.
+3. (parallel) Each plan line looks up its settlement; it only counts if it was defined earlier.
+4. (serial)   Diagnostics are printed in file order and plan IDs are handed out.
+5. (parallel) The plans are built.
+The diagnostics and plan IDs are the same as reading the file line by line.
+*/
+namespace
+{
+    enum class LineKind : uint8_t
+    {
+        SETTLEMENT,
+        FACILITY,
+        PLAN,
+        OTHER, // Invalid, only produces its diagnostic
+    };
+
+    enum class Diagnostic : uint8_t
+    {
+        NONE,
+        INVALID_LINE,
+        INVALID_SETTLEMENT_TYPE,
+        DUPLICATE_SETTLEMENT,
+        INVALID_FACILITY_CATEGORY,
+        DUPLICATE_FACILITY,
+        INVALID_POLICY,
+        UNKNOWN_SETTLEMENT,
+    };
+
+    const int8_t NO_POLICY = -1; // A plan line's policy otherwise holds its PolicyKind
+
+    // One non-empty config line after splitting
+    struct ConfigLine
+    {
+        const char *line;
+        uint32_t lineLength;
+        uint32_t nameOffset; // The second argument, relative to line
+        uint32_t nameLength;
+        LineKind kind;
+        Diagnostic diagnostic;
+        int8_t policy;
+        int values[5]; // Settlement type, or facility category, price and scores
+        int target;    // For a plan: its settlement's index, then its plan ID (-1 if it is not added)
+    };
+
+    struct ConfigShard
+    {
+        ConfigShard() : begin(nullptr), end(nullptr), lines(), firstPosition(0) {}
+        ConfigShard(const ConfigShard &other) = default;
+        ConfigShard &operator=(const ConfigShard &other) = default;
+
+        const char *begin;
+        const char *end;
+        vector<ConfigLine> lines;
+        size_t firstPosition; // Position of lines[0] among all the file's lines
+    };
+
+    // The PolicyKind a plan line names, or NO_POLICY
+    int8_t policyKind(const ArgumentView &name)
+    {
+        static const struct
+        {
+            const char *name;
+            PolicyKind kind;
+        } names[] = {{"nve", PolicyKind::NAIVE}, {"bal", PolicyKind::BALANCED}, {"eco", PolicyKind::ECONOMY}, {"env", PolicyKind::SUSTAINABILITY}};
+
+        for (const auto &entry : names)
+        {
+            if (name == entry.name)
+            {
+                return static_cast<int8_t>(entry.kind);
+            }
+        }
+        return NO_POLICY;
+    }
+
+    // Split and classify the lines of one shard. Only checks that need no other line happen here.
+    void parseShard(ConfigShard &shard)
+    {
+        ArgumentView args[7];
+        const char *cursor = shard.begin;
+        while (cursor < shard.end)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', shard.end - cursor));
+            if (!lineEnd)
+            {
+                lineEnd = shard.end;
+            }
+            int argCount = Auxiliary::splitArguments(cursor, lineEnd, args, 7);
+            if (argCount > 0)
+            {
+                ConfigLine entry = ConfigLine();
+                entry.line = cursor;
+                entry.lineLength = static_cast<uint32_t>(lineEnd - cursor);
+                entry.kind = LineKind::OTHER;
+                entry.diagnostic = Diagnostic::INVALID_LINE;
+                entry.target = -1;
+                if (argCount > 1)
+                {
+                    entry.nameOffset = static_cast<uint32_t>(args[1].begin - cursor);
+                    entry.nameLength = static_cast<uint32_t>(args[1].length);
+                }
+
+                if (args[0] == "settlement" && argCount == 3)
+                {
+                    if (Auxiliary::parseInt(args[2], entry.values[0]))
+                    {
+                        bool known = entry.values[0] >= 0 && entry.values[0] <= 2;
+                        entry.kind = known ? LineKind::SETTLEMENT : LineKind::OTHER;
+                        entry.diagnostic = known ? Diagnostic::NONE : Diagnostic::INVALID_SETTLEMENT_TYPE;
+                    }
+                }
+                else if (args[0] == "facility" && argCount == 7)
+                {
+                    bool numeric = true;
+                    for (int i = 0; i < 5 && numeric; ++i)
+                    {
+                        numeric = Auxiliary::parseInt(args[i + 2], entry.values[i]);
+                    }
+                    if (numeric)
+                    {
+                        bool known = entry.values[0] >= 0 && entry.values[0] <= 2;
+                        entry.kind = known ? LineKind::FACILITY : LineKind::OTHER;
+                        entry.diagnostic = known ? Diagnostic::NONE : Diagnostic::INVALID_FACILITY_CATEGORY;
+                    }
+                }
+                else if (args[0] == "plan" && argCount == 3)
+                {
+                    entry.kind = LineKind::PLAN;
+                    entry.diagnostic = Diagnostic::NONE;
+                    entry.policy = policyKind(args[2]);
+                }
+                else if (args[0] == "plan" && (argCount == 4 || argCount == 7) && args[2] == "opt")
+                {
+                    // values: horizon and weights
+                    entry.kind = LineKind::PLAN;
+                    entry.diagnostic = Diagnostic::NONE;
+                    bool known = true;
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        entry.values[i] = 1;
+                        known = known && (i + 3 >= argCount || Auxiliary::parseInt(args[i + 3], entry.values[i]));
+                    }
+                    known = known && LookAheadSelection::isValid(LookAheadSettings{entry.values[0], entry.values[1], entry.values[2], entry.values[3]});
+                    entry.policy = known ? static_cast<int8_t>(PolicyKind::LOOK_AHEAD) : NO_POLICY;
+                }
+                shard.lines.push_back(entry);
+            }
+            cursor = lineEnd + 1;
+        }
+    }
+
+    // Print a diagnostic the way the line-by-line loader did
+    void report(const ConfigLine &entry)
+    {
+        const char *name = entry.line + entry.nameOffset;
+        switch (entry.diagnostic)
+        {
+        case Diagnostic::NONE:
+            return;
+        case Diagnostic::INVALID_LINE:
+            cout << "Invalid line format: ";
+            break;
+        case Diagnostic::INVALID_SETTLEMENT_TYPE:
+            cout << "Invalid settlement type in line: ";
+            break;
+        case Diagnostic::INVALID_FACILITY_CATEGORY:
+            cout << "Invalid facility category in line: ";
+            break;
+        case Diagnostic::INVALID_POLICY:
+            cout << "Invalid selection policy in line: ";
+            break;
+        case Diagnostic::DUPLICATE_SETTLEMENT:
+            cout << "Duplicate settlement: ";
+            cout.write(name, entry.nameLength) << '\n';
+            return;
+        case Diagnostic::DUPLICATE_FACILITY:
+            cout << "Duplicate facility: ";
+            cout.write(name, entry.nameLength) << '\n';
+            return;
+        case Diagnostic::UNKNOWN_SETTLEMENT:
+            cout << "Settlement: ";
+            cout.write(name, entry.nameLength) << " do not exists" << '\n';
+            return;
+        }
+        cout.write(entry.line, entry.lineLength) << '\n';
+    }
+}
+
+// Read the settlements, facility types and plans of a config file (or of a compiled config)
+void Simulation::loadConfig(const string &configFilePath)
+{
+    MappedFile configFile(configFilePath);
+
+    if (!configFile.isOpen())
+    {
+        throw runtime_error("Failed to open configuration file: " + configFilePath);
+    }
+
+    // A compiled config is loaded as is, unless its source changed since it was compiled
+    if (isSnapshot(configFile.data(), configFile.size()))
+    {
+        string sourcePath;
+        if (!loadConfigImage(configFile, configFilePath, sourcePath))
+        {
+            cerr << "Compiled config " << configFilePath << " is out of date, reading " << sourcePath << endl;
+            loadConfig(sourcePath);
+        }
+        return;
+    }
+
+    // Cut the file into line-aligned shards, a few per worker so uneven shards even out
+    const char *fileBegin = configFile.data();
+    const char *fileEnd = fileBegin + configFile.size();
+    size_t shardCount = workerPool ? workerPool->size() * 4 : 1;
+    vector<ConfigShard> shards(shardCount);
+    const char *cursor = fileBegin;
+    for (size_t i = 0; i < shardCount; ++i)
+    {
+        shards[i].begin = cursor;
+        const char *cut = i + 1 == shardCount ? fileEnd : fileBegin + configFile.size() * (i + 1) / shardCount;
+        if (cut < cursor)
+        {
+            cut = cursor;
+        }
+        const char *lineEnd = cut < fileEnd ? static_cast<const char *>(memchr(cut, '\n', fileEnd - cut)) : nullptr;
+        cursor = lineEnd ? lineEnd + 1 : fileEnd;
+        shards[i].end = cursor;
+    }
+
+    auto forEachShard = [this, &shards](const std::function<void(ConfigShard &)> &task)
+    {
+        if (!workerPool || shards.size() < 2)
+        {
+            for (ConfigShard &shard : shards)
+            {
+                task(shard);
+            }
+            return;
+        }
+        workerPool->parallelFor(shards.size(), [&shards, &task](size_t begin, size_t end)
+                                {
+            for (size_t i = begin; i < end; ++i)
+            {
+                task(shards[i]);
+            } });
+    };
+
+    forEachShard(parseShard);
+
+    // Settlements and facility types, in file order. settlementPositions remembers where each
+    // settlement was defined, since a plan can only use a settlement defined above it.
+    vector<size_t> settlementPositions;
+    string name;
+    size_t position = 0;
+    for (ConfigShard &shard : shards)
+    {
+        shard.firstPosition = position;
+        position += shard.lines.size();
+        for (ConfigLine &entry : shard.lines)
+        {
+            if (entry.kind == LineKind::SETTLEMENT)
+            {
+                name.assign(entry.line + entry.nameOffset, entry.nameLength);
+                if (!settlements.add(name, std::make_shared<Settlement>(name, static_cast<SettlementType>(entry.values[0]))))
+                {
+                    entry.diagnostic = Diagnostic::DUPLICATE_SETTLEMENT;
+                    continue;
+                }
+                settlementPositions.push_back(shard.firstPosition + (&entry - shard.lines.data()));
+            }
+            else if (entry.kind == LineKind::FACILITY)
+            {
+                FacilityType facility(string(entry.line + entry.nameOffset, entry.nameLength), static_cast<FacilityCategory>(entry.values[0]),
+                                      entry.values[1], entry.values[2], entry.values[3], entry.values[4]);
+                if (!addFacility(facility))
+                {
+                    entry.diagnostic = Diagnostic::DUPLICATE_FACILITY;
+                }
+            }
+        }
+    }
+
+    // Settlement lookups for the plans only read the settlement index
+    forEachShard([this, &settlementPositions](ConfigShard &shard)
+                 {
+        string name;
+        for (size_t i = 0; i < shard.lines.size(); ++i)
+        {
+            ConfigLine &entry = shard.lines[i];
+            if (entry.kind != LineKind::PLAN)
+            {
+                continue;
+            }
+            name.assign(entry.line + entry.nameOffset, entry.nameLength);
+            int index = settlements.find(name);
+            if (index < 0 || settlementPositions[index] > shard.firstPosition + i)
+            {
+                entry.diagnostic = Diagnostic::UNKNOWN_SETTLEMENT;
+            }
+            else if (entry.policy == NO_POLICY)
+            {
+                entry.diagnostic = Diagnostic::INVALID_POLICY;
+            }
+            else
+            {
+                entry.target = index;
+            }
+        } });
+
+    // Diagnostics and plan IDs, in file order
+    vector<int> planSettlements;
+    for (ConfigShard &shard : shards)
+    {
+        for (ConfigLine &entry : shard.lines)
+        {
+            report(entry);
+            if (entry.kind == LineKind::PLAN && entry.diagnostic == Diagnostic::NONE)
+            {
+                planSettlements.push_back(entry.target);
+                entry.target = planCounter++;
+            }
+        }
+    }
+    cout.flush();
+
+    vector<std::shared_ptr<Plan>> &allPlans = ownPlans();
+    allPlans.resize(planCounter);
+    const FacilityCatalog &catalog = facilitiesOptions.items();
+    forEachShard([this, &allPlans, &planSettlements, &catalog](ConfigShard &shard)
+                 {
+        for (const ConfigLine &entry : shard.lines)
+        {
+            if (entry.kind == LineKind::PLAN && entry.diagnostic == Diagnostic::NONE)
+            {
+                const Settlement &settlement = *settlements[planSettlements[entry.target]];
+                allPlans[entry.target] = std::make_shared<Plan>(entry.target, settlement, SelectionPolicy::create(static_cast<PolicyKind>(entry.policy), 0, 0, 0, LookAheadSettings{entry.values[0], entry.values[1], entry.values[2], entry.values[3]}), catalog);
+            }
+        } });
+}
@@ -0,0 +1,549 @@
+#include "Simulation.h"
+#include "SelectionPolicy.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <climits>
+#include <cstdlib>
+#include <sys/stat.h>
+
+using namespace std;
+
+/*
+Binary snapshot of a simulation, written by `save <path>` and read back by `load <path>`.
+
+The file is a SnapshotHeader followed by fixed-size record arrays, each starting on a 4-byte
+boundary: the string table, FacilityRecord[], SettlementRecord[], PlanRecord[], FacilityCount[]
+and SlotRecord[]. Records are stored in host byte order; endianTag rejects files from a machine
+with a different one. Loading maps the file and builds the objects straight from the arrays.
+
+A compiled config (`simulation compile <config> <image>`) is a snapshot of the freshly loaded
+config followed by a SourceRecord: the config's path, size, mtime and hash, and the diagnostics
+reading it printed. The constructor loads such an image instead of parsing, unless the config
+changed since it was compiled.
+*/
+namespace
+{
+    const char SNAPSHOT_MAGIC[8] = {'S', 'P', 'L', 'S', 'N', 'A', 'P', '\0'};
+    const uint32_t SNAPSHOT_VERSION = 2; // 2: plans keep their status
+    const uint32_t SNAPSHOT_ENDIAN_TAG = 0x01020304;
+
+    enum PolicyRecordKind : int32_t // On disk; independent of PolicyKind so the format stays fixed
+    {
+        NAIVE_POLICY,
+        BALANCED_POLICY,
+        ECONOMY_POLICY,
+        SUSTAINABILITY_POLICY,
+        LOOK_AHEAD_POLICY, // lastSelectedIndex holds the horizon, the policy scores the weights
+    };
+
+    enum PlanStatusRecord : int32_t // On disk, like PolicyRecordKind
+    {
+        AVAILABLE_PLAN,
+        BUSY_PLAN,
+    };
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t endianTag;
+        int32_t planCounter;
+        uint32_t stringBytes;
+        uint32_t facilityCount;
+        uint32_t settlementCount;
+        uint32_t planCount;
+        uint32_t countCount;
+        uint32_t slotCount;
+        uint32_t sourceBytes; // Size of the source section after the slots (compiled configs only)
+    };
+
+    struct FacilityRecord
+    {
+        uint32_t nameOffset, nameLength;
+        int32_t category, price, lifeQuality, economy, environment;
+    };
+
+    struct SettlementRecord
+    {
+        uint32_t nameOffset, nameLength;
+        int32_t type;
+    };
+
+    struct PlanRecord
+    {
+        int32_t id, settlement;
+        int32_t policy, lastSelectedIndex, policyLifeQuality, policyEconomy, policyEnvironment;
+        int32_t lifeQuality, economy, environment, status;
+        uint32_t firstCount, countLength, firstSlot, slotLength;
+    };
+
+    struct SlotRecord
+    {
+        int32_t typeIndex, timeLeft;
+    };
+
+    // Followed by the config's path and its diagnostics text
+    struct SourceRecord
+    {
+        uint64_t size;
+        int64_t mtimeSeconds, mtimeNanoseconds;
+        uint64_t hash;
+        uint32_t pathLength, diagnosticsLength;
+    };
+
+    size_t padded(size_t bytes)
+    {
+        return (bytes + 3) & ~size_t(3);
+    }
+
+    uint32_t appendString(string &table, const string &value)
+    {
+        uint32_t offset = static_cast<uint32_t>(table.size());
+        table += value;
+        return offset;
+    }
+
+    // FNV-1a over a whole file
+    uint64_t hashBytes(const char *data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    bool statSource(const string &path, SourceRecord &source)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            return false;
+        }
+        source.size = static_cast<uint64_t>(info.st_size);
+        source.mtimeSeconds = info.st_mtim.tv_sec;
+        source.mtimeNanoseconds = info.st_mtim.tv_nsec;
+        return true;
+    }
+
+    // Sends cout to a buffer for as long as it lives
+    class CaptureOutput
+    {
+    public:
+        CaptureOutput() : buffer(), console(cout.rdbuf(buffer.rdbuf())) {}
+        ~CaptureOutput() { cout.rdbuf(console); }
+        CaptureOutput(const CaptureOutput &other) = delete;
+        CaptureOutput &operator=(const CaptureOutput &other) = delete;
+
+        string text() const { return buffer.str(); }
+
+    private:
+        ostringstream buffer;
+        streambuf *console;
+    };
+
+    const SnapshotHeader &checkedHeader(const MappedFile &file, const string &path)
+    {
+        if (file.size() < sizeof(SnapshotHeader))
+        {
+            throw runtime_error("Not a snapshot file: " + path);
+        }
+        const SnapshotHeader &header = *reinterpret_cast<const SnapshotHeader *>(file.data());
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.endianTag != SNAPSHOT_ENDIAN_TAG)
+        {
+            throw runtime_error("Not a snapshot file: " + path);
+        }
+        if (header.version != SNAPSHOT_VERSION)
+        {
+            throw runtime_error("Unsupported snapshot version: " + to_string(header.version));
+        }
+        return header;
+    }
+
+    // Where the source section of a compiled config starts
+    size_t sourceOffset(const SnapshotHeader &header)
+    {
+        return sizeof(SnapshotHeader) + padded(header.stringBytes) + padded(sizeof(FacilityRecord) * header.facilityCount) +
+               padded(sizeof(SettlementRecord) * header.settlementCount) + padded(sizeof(PlanRecord) * header.planCount) +
+               padded(sizeof(FacilityCount) * header.countCount) + padded(sizeof(SlotRecord) * header.slotCount);
+    }
+
+    // Typed view of one record array inside the mapped file
+    template <typename Record>
+    const Record *section(const MappedFile &file, size_t &offset, uint32_t count)
+    {
+        const Record *records = reinterpret_cast<const Record *>(file.data() + offset);
+        offset += padded(sizeof(Record) * count);
+        if (offset > file.size())
+        {
+            throw runtime_error("Corrupt snapshot file: truncated");
+        }
+        return records;
+    }
+}
+
+// Write the settlements, facility types and plans (with their policies) to a binary file
+void Simulation::saveSnapshot(const string &path) const
+{
+    writeSnapshot(path, string());
+}
+
+// The snapshot file, followed by the source section of a compiled config if there is one
+void Simulation::writeSnapshot(const string &path, const string &source) const
+{
+    string strings;
+    vector<FacilityRecord> facilityRecords;
+    vector<SettlementRecord> settlementRecords;
+    vector<PlanRecord> planRecords;
+    vector<FacilityCount> countRecords;
+    vector<SlotRecord> slotRecords;
+
+    for (const FacilityType &facility : facilitiesOptions)
+    {
+        facilityRecords.push_back(FacilityRecord{appendString(strings, facility.getName()), static_cast<uint32_t>(facility.getName().size()),
+                                                 static_cast<int32_t>(facility.getCategory()), facility.getCost(), facility.getLifeQualityScore(),
+                                                 facility.getEconomyScore(), facility.getEnvironmentScore()});
+    }
+    for (const auto &settlement : settlements)
+    {
+        settlementRecords.push_back(SettlementRecord{appendString(strings, settlement->getName()), static_cast<uint32_t>(settlement->getName().size()),
+                                                     static_cast<int32_t>(settlement->getType())});
+    }
+    for (const auto &plan : *plans)
+    {
+        PlanRecord record = PlanRecord();
+        record.id = plan->getPlanId();
+        record.settlement = settlements.find(plan->getSettlement().getName());
+        const SelectionPolicy &policy = plan->getSelectionPolicy();
+        switch (policy.getKind())
+        {
+        case PolicyKind::BALANCED:
+        {
+            const BalancedSelection &balanced = static_cast<const BalancedSelection &>(policy);
+            record.policy = BALANCED_POLICY;
+            record.policyLifeQuality = balanced.getLifeQualityScore();
+            record.policyEconomy = balanced.getEconomyScore();
+            record.policyEnvironment = balanced.getEnvironmentScore();
+            break;
+        }
+        case PolicyKind::ECONOMY:
+            record.policy = ECONOMY_POLICY;
+            break;
+        case PolicyKind::SUSTAINABILITY:
+            record.policy = SUSTAINABILITY_POLICY;
+            break;
+        case PolicyKind::NAIVE:
+            record.policy = NAIVE_POLICY;
+            break;
+        case PolicyKind::LOOK_AHEAD:
+        {
+            const LookAheadSettings &settings = static_cast<const LookAheadSelection &>(policy).getSettings();
+            record.policy = LOOK_AHEAD_POLICY;
+            record.lastSelectedIndex = settings.horizon;
+            record.policyLifeQuality = settings.lifeQualityWeight;
+            record.policyEconomy = settings.economyWeight;
+            record.policyEnvironment = settings.environmentWeight;
+            break;
+        }
+        }
+        if (record.policy != BALANCED_POLICY && record.policy != LOOK_AHEAD_POLICY)
+        {
+            record.lastSelectedIndex = policy.getCursor() - 1;
+        }
+        record.lifeQuality = plan->getlifeQualityScore();
+        record.economy = plan->getEconomyScore();
+        record.environment = plan->getEnvironmentScore();
+        record.status = plan->getStatus() == PlanStatus::BUSY ? BUSY_PLAN : AVAILABLE_PLAN;
+        record.firstCount = static_cast<uint32_t>(countRecords.size());
+        record.countLength = static_cast<uint32_t>(plan->getFacilityCounts().size());
+        countRecords.insert(countRecords.end(), plan->getFacilityCounts().begin(), plan->getFacilityCounts().end());
+        record.firstSlot = static_cast<uint32_t>(slotRecords.size());
+        record.slotLength = static_cast<uint32_t>(plan->getUnderConstruction().size());
+        for (const Facility &facility : plan->getUnderConstruction())
+        {
+            slotRecords.push_back(SlotRecord{facility.getTypeIndex(), facility.getTimeLeft()});
+        }
+        planRecords.push_back(record);
+    }
+
+    SnapshotHeader header = SnapshotHeader();
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.endianTag = SNAPSHOT_ENDIAN_TAG;
+    header.planCounter = planCounter;
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+    header.facilityCount = static_cast<uint32_t>(facilityRecords.size());
+    header.settlementCount = static_cast<uint32_t>(settlementRecords.size());
+    header.planCount = static_cast<uint32_t>(planRecords.size());
+    header.countCount = static_cast<uint32_t>(countRecords.size());
+    header.slotCount = static_cast<uint32_t>(slotRecords.size());
+    header.sourceBytes = static_cast<uint32_t>(source.size());
+    strings.resize(padded(strings.size()), '\0');
+
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open())
+    {
+        throw runtime_error("Failed to open snapshot file: " + path);
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(strings.data(), strings.size());
+    file.write(reinterpret_cast<const char *>(facilityRecords.data()), sizeof(FacilityRecord) * facilityRecords.size());
+    file.write(reinterpret_cast<const char *>(settlementRecords.data()), sizeof(SettlementRecord) * settlementRecords.size());
+    file.write(reinterpret_cast<const char *>(planRecords.data()), sizeof(PlanRecord) * planRecords.size());
+    file.write(reinterpret_cast<const char *>(countRecords.data()), sizeof(FacilityCount) * countRecords.size());
+    file.write(reinterpret_cast<const char *>(slotRecords.data()), sizeof(SlotRecord) * slotRecords.size());
+    file.write(source.data(), source.size());
+    if (!file)
+    {
+        throw runtime_error("Failed to write snapshot file: " + path);
+    }
+}
+
+// Replace the settlements, facility types and plans with the ones saved in a snapshot file.
+// The actions log is kept. Throws (leaving the simulation untouched) if the file is unusable:
+// truncated, or holding a record that save could not have written.
+void Simulation::loadSnapshot(const string &path)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        throw runtime_error("Failed to open snapshot file: " + path);
+    }
+    restoreSnapshot(file, path);
+}
+
+void Simulation::restoreSnapshot(const MappedFile &file, const string &path)
+{
+    const SnapshotHeader &header = checkedHeader(file, path);
+
+    size_t offset = sizeof(SnapshotHeader);
+    const char *strings = section<char>(file, offset, header.stringBytes);
+    const FacilityRecord *facilityRecords = section<FacilityRecord>(file, offset, header.facilityCount);
+    const SettlementRecord *settlementRecords = section<SettlementRecord>(file, offset, header.settlementCount);
+    const PlanRecord *planRecords = section<PlanRecord>(file, offset, header.planCount);
+    const FacilityCount *countRecords = section<FacilityCount>(file, offset, header.countCount);
+    const SlotRecord *slotRecords = section<SlotRecord>(file, offset, header.slotCount);
+
+    auto name = [&](uint32_t nameOffset, uint32_t nameLength)
+    {
+        if (nameOffset > header.stringBytes || nameLength > header.stringBytes - nameOffset)
+        {
+            throw runtime_error("Corrupt snapshot file: bad name");
+        }
+        return string(strings + nameOffset, nameLength);
+    };
+
+    // Plans are indexed by ID, and new plans take the next one
+    if (header.planCounter < 0 || (uint32_t)header.planCounter != header.planCount)
+    {
+        throw runtime_error("Corrupt snapshot file: bad plan counter");
+    }
+
+    SharedStore<FacilityType, FacilityCatalog> newFacilities;
+    for (uint32_t i = 0; i < header.facilityCount; ++i)
+    {
+        const FacilityRecord &record = facilityRecords[i];
+        if (record.category < static_cast<int32_t>(FacilityCategory::LIFE_QUALITY) || record.category > static_cast<int32_t>(FacilityCategory::ENVIRONMENT))
+        {
+            throw runtime_error("Corrupt snapshot file: bad category of facility " + to_string(i));
+        }
+        FacilityType facility(name(record.nameOffset, record.nameLength), static_cast<FacilityCategory>(record.category), record.price,
+                              record.lifeQuality, record.economy, record.environment);
+        if (!newFacilities.add(facility.getName(), facility))
+        {
+            throw runtime_error("Corrupt snapshot file: duplicate facility " + facility.getName());
+        }
+    }
+    // Settlement types past METROPOLIS are kept: "settlement <name> <type>" accepts them, and their plans
+    // get type + 1 construction slots like any other
+    SharedStore<std::shared_ptr<Settlement>> newSettlements;
+    for (uint32_t i = 0; i < header.settlementCount; ++i)
+    {
+        const SettlementRecord &record = settlementRecords[i];
+        std::shared_ptr<Settlement> settlement = std::make_shared<Settlement>(name(record.nameOffset, record.nameLength), static_cast<SettlementType>(record.type));
+        if (!newSettlements.add(settlement->getName(), settlement))
+        {
+            throw runtime_error("Corrupt snapshot file: duplicate settlement " + settlement->getName());
+        }
+    }
+
+    const FacilityCatalog &catalog = newFacilities.items();
+    auto newPlans = std::make_shared<vector<std::shared_ptr<Plan>>>();
+    newPlans->resize(header.planCount);
+    // Plans are built independently, so they can be split across the worker pool
+    auto buildPlans = [&](size_t begin, size_t end)
+    {
+        vector<int> typeIndexes; // A plan's counted types, sorted to find one counted twice
+        for (size_t i = begin; i < end; ++i)
+        {
+            const PlanRecord &record = planRecords[i];
+            LookAheadSettings lookAheadSettings{record.lastSelectedIndex, record.policyLifeQuality, record.policyEconomy, record.policyEnvironment};
+            bool roundRobin = record.policy == NAIVE_POLICY || record.policy == ECONOMY_POLICY || record.policy == SUSTAINABILITY_POLICY;
+            if (record.id != (int32_t)i || record.settlement < 0 || record.settlement >= (int32_t)header.settlementCount ||
+                record.policy < NAIVE_POLICY || record.policy > LOOK_AHEAD_POLICY ||
+                (roundRobin && (record.lastSelectedIndex < -1 || record.lastSelectedIndex >= (int32_t)header.facilityCount)) ||
+                (record.policy == LOOK_AHEAD_POLICY && !LookAheadSelection::isValid(lookAheadSettings)) ||
+                (record.status != AVAILABLE_PLAN && record.status != BUSY_PLAN) ||
+                record.firstCount > header.countCount || record.countLength > header.countCount - record.firstCount ||
+                record.firstSlot > header.slotCount || record.slotLength > header.slotCount - record.firstSlot)
+            {
+                throw runtime_error("Corrupt snapshot file: bad plan " + to_string(i));
+            }
+            const Settlement &settlement = *newSettlements[record.settlement];
+            long long constructionLimit = static_cast<long long>(settlement.getType()) + 1;
+            if (record.slotLength > std::max(constructionLimit, 0LL))
+            {
+                throw runtime_error("Corrupt snapshot file: too many facilities under construction in plan " + to_string(i));
+            }
+
+            vector<FacilityCount> counts(countRecords + record.firstCount, countRecords + record.firstCount + record.countLength);
+            vector<Facility> underConstruction;
+            underConstruction.reserve(record.slotLength);
+            typeIndexes.clear();
+            for (const FacilityCount &count : counts)
+            {
+                if (count.typeIndex < 0 || count.typeIndex >= (int)catalog.size() || count.count < 1)
+                {
+                    throw runtime_error("Corrupt snapshot file: bad facility in plan " + to_string(i));
+                }
+                typeIndexes.push_back(count.typeIndex);
+            }
+            std::sort(typeIndexes.begin(), typeIndexes.end());
+            if (std::adjacent_find(typeIndexes.begin(), typeIndexes.end()) != typeIndexes.end())
+            {
+                throw runtime_error("Corrupt snapshot file: bad facility in plan " + to_string(i));
+            }
+            for (uint32_t s = record.firstSlot; s < record.firstSlot + record.slotLength; ++s)
+            {
+                if (slotRecords[s].typeIndex < 0 || slotRecords[s].typeIndex >= (int)catalog.size())
+                {
+                    throw runtime_error("Corrupt snapshot file: bad facility in plan " + to_string(i));
+                }
+                underConstruction.push_back(Facility(catalog, slotRecords[s].typeIndex, settlement, slotRecords[s].timeLeft));
+            }
+
+            SelectionPolicy *policy = nullptr;
+            switch (record.policy)
+            {
+            case BALANCED_POLICY:
+                policy = new BalancedSelection(record.policyLifeQuality, record.policyEconomy, record.policyEnvironment);
+                break;
+            case ECONOMY_POLICY:
+                policy = new EconomySelection(record.lastSelectedIndex);
+                break;
+            case SUSTAINABILITY_POLICY:
+                policy = new SustainabilitySelection(record.lastSelectedIndex);
+                break;
+            case LOOK_AHEAD_POLICY:
+                policy = new LookAheadSelection(lookAheadSettings);
+                break;
+            default:
+                policy = new NaiveSelection(record.lastSelectedIndex);
+                break;
+            }
+            PlanStatus status = record.status == BUSY_PLAN ? PlanStatus::BUSY : PlanStatus::AVALIABLE;
+            (*newPlans)[i] = std::make_shared<Plan>(record.id, settlement, policy, status, catalog, record.lifeQuality, record.economy,
+                                                    record.environment, std::move(counts), std::move(underConstruction));
+        }
+    };
+    if (workerPool && header.planCount > 1)
+    {
+        workerPool->parallelFor(header.planCount, buildPlans);
+    }
+    else
+    {
+        buildPlans(0, header.planCount);
+    }
+
+    plans = newPlans;
+    facilitiesOptions = newFacilities;
+    settlements = newSettlements;
+    planCounter = header.planCounter;
+}
+
+bool Simulation::isSnapshot(const char *data, size_t size)
+{
+    return size >= sizeof(SNAPSHOT_MAGIC) && memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+}
+
+// Load a config and save it as an image the constructor can load without parsing
+void Simulation::compileConfig(const string &configFilePath, const string &imagePath, int workerCount)
+{
+    MappedFile config(configFilePath);
+    if (!config.isOpen())
+    {
+        throw runtime_error("Failed to open configuration file: " + configFilePath);
+    }
+    if (isSnapshot(config.data(), config.size()))
+    {
+        throw runtime_error("Already compiled: " + configFilePath);
+    }
+
+    char resolved[PATH_MAX];
+    string sourcePath = realpath(configFilePath.c_str(), resolved) ? string(resolved) : configFilePath;
+    SourceRecord source = SourceRecord();
+    statSource(sourcePath, source);
+    source.hash = hashBytes(config.data(), config.size());
+
+    string diagnostics;
+    {
+        CaptureOutput capture;
+        Simulation simulation(configFilePath, workerCount);
+        diagnostics = capture.text();
+        source.pathLength = static_cast<uint32_t>(sourcePath.size());
+        source.diagnosticsLength = static_cast<uint32_t>(diagnostics.size());
+        string section(reinterpret_cast<const char *>(&source), sizeof(source));
+        section += sourcePath;
+        section += diagnostics;
+        simulation.writeSnapshot(imagePath, section);
+    }
+    cout << diagnostics;
+}
+
+// Load a compiled config. Returns false, loading nothing, if its source config has changed since
+// (a different size, or a different mtime and hash); sourcePath is then set to the config.
+bool Simulation::loadConfigImage(const MappedFile &image, const string &imagePath, string &sourcePath)
+{
+    const SnapshotHeader &header = checkedHeader(image, imagePath);
+    string diagnostics;
+    size_t offset = sourceOffset(header);
+    if (header.sourceBytes > 0)
+    {
+        SourceRecord source;
+        if (header.sourceBytes < sizeof(source) || offset + header.sourceBytes > image.size())
+        {
+            throw runtime_error("Corrupt snapshot file: bad source");
+        }
+        memcpy(&source, image.data() + offset, sizeof(source));
+        if (sizeof(source) + (uint64_t)source.pathLength + source.diagnosticsLength > header.sourceBytes)
+        {
+            throw runtime_error("Corrupt snapshot file: bad source");
+        }
+        const char *text = image.data() + offset + sizeof(source);
+        sourcePath.assign(text, source.pathLength);
+        diagnostics.assign(text + source.pathLength, source.diagnosticsLength);
+
+        // A config that is gone is not stale; the image is all that is left of it
+        SourceRecord current = SourceRecord();
+        if (statSource(sourcePath, current) &&
+            (current.size != source.size || current.mtimeSeconds != source.mtimeSeconds || current.mtimeNanoseconds != source.mtimeNanoseconds))
+        {
+            MappedFile config(sourcePath);
+            if (current.size != source.size || !config.isOpen() || hashBytes(config.data(), config.size()) != source.hash)
+            {
+                return false;
+            }
+        }
+    }
+
+    restoreSnapshot(image, imagePath);
+    cout << diagnostics;
+    return true;
+}
@@ -0,0 +1,125 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int workerCount)
+    : workers(), mutex(), workReady(), workDone(), task(nullptr), count(0), chunkSize(1), nextChunk(0),
+      activeWorkers(0), generation(0), stopping(false), failure()
+{
+    // The calling thread works too, so spawn one thread less than requested
+    for (int i = 1; i < workerCount; ++i)
+    {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+int ThreadPool::size() const
+{
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)> &task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (workers.empty() || count == 1)
+    {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        // A few chunks per thread keeps the load balanced when plans differ in cost
+        chunkSize = count / (4 * size()) + 1;
+        nextChunk = 0;
+        activeWorkers = static_cast<int>(workers.size());
+        failure = nullptr;
+        ++generation;
+    }
+    workReady.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]
+                  { return activeWorkers == 0; });
+    this->task = nullptr;
+    if (failure)
+    {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    unsigned long seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [this, seenGeneration]
+                           { return stopping || generation != seenGeneration; });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeWorkers == 0)
+        {
+            workDone.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks()
+{
+    while (true)
+    {
+        size_t begin;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextChunk >= count || failure)
+            {
+                return;
+            }
+            begin = nextChunk;
+            nextChunk += chunkSize;
+        }
+        size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+        try
+        {
+            (*task)(begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+}
@@ -1,21 +1,71 @@
 #include "Simulation.h"
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 
 using namespace std;
 
 Simulation *backup = nullptr;
 
+// Worker thread count from the command line, or 0 when it is not a whole number of at least 1
+static int parseWorkers(const char *text)
+{
+    char *end = nullptr;
+    long workers = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || workers < 1 || workers > INT_MAX)
+    {
+        return 0;
+    }
+    return static_cast<int>(workers);
+}
+
+static void printUsage()
+{
+    cout << "usage: simulation <config_path> [worker_threads] [--batch [commands_path]]" << endl;
+    cout << "       simulation compile <config_path> <image_path> [worker_threads]" << endl;
+}
+
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    if (argc >= 4 && string(argv[1]) == "compile")
+    {
+        int workers = argc == 5 ? parseWorkers(argv[4]) : 1;
+        if (argc > 5 || workers == 0)
+        {
+            printUsage();
+            return 0;
+        }
+        Simulation::compileConfig(argv[2], argv[3], workers);
+        cout << "Compiled " << argv[2] << " into " << argv[3] << endl;
+        return 0;
+    }
+    // simulation <config_path> [worker_threads] [--batch [commands_path]]
+    int batchAt = argc;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (string(argv[i]) == "--batch")
+        {
+            batchAt = i;
+            break;
+        }
+    }
+    int workers = batchAt == 3 ? parseWorkers(argv[2]) : 1;
+    if (argc < 2 || batchAt > 3 || argc > batchAt + 2 || workers == 0)
     {
-        cout << "usage: simulation <config_path>" << endl;
+        printUsage();
         return 0;
     }
 
     string configurationFile = argv[1];
-    Simulation simulation(configurationFile);
-    simulation.start();
+    Simulation simulation(configurationFile, workers);
+    if (batchAt < argc)
+    {
+        simulation.startBatch(batchAt + 1 < argc ? argv[batchAt + 1] : "-"); // Commands from standard input by default
+    }
+    else
+    {
+        simulation.start();
+    }
     if (backup != nullptr)
     {
         delete backup;